@@ -0,0 +1,438 @@
+/*
+  Benchmarks for the simulation and canonicalization kernels.
+
+  This file includes ../brute-force/simple.c (with its main renamed), so it
+  times exactly the kernels the driver runs rather than a copy of them.
+
+  For every n in the range it builds two fixed input sets from a fixed
+  seed:
+    - random:      uniform states over the n x n board, the kind the
+                   exhaustive enumeration sees (they settle in a few steps)
+    - adversarial: the longest-running states out of a pool of sparse
+                   random ones (n-1 to n+2 cells), close to the maximizers
+  and runs each kernel variant over them until at least --seconds have
+  passed. Every result reports states/sec, ns/step (a step being one
+  generation, so a state of length L costs L steps) and cycles/state.
+  Cycles come from the time-stamp counter, which ticks at the nominal
+  clock rather than the boosted one; they are only comparable on the same
+  machine.
+
+  The checksum of a result is the sum of the lengths (or of the canonical
+  representatives); variants of one kernel must agree on it.
+
+  Build:  make benchmark/bench     (from code-implementations/)
+  Usage:  bench [--n-min N] [--n-max N] [--seconds S] [--out FILE]
+  The JSON goes to FILE, or alone to stdout without --out; the summary
+  table goes to stderr.
+*/
+
+#define main simpleMain
+#include "../brute-force/simple.c"
+#undef main
+
+#include <stdlib.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>      // __rdtsc()
+#endif
+
+#define INPUT_COUNT 4096
+#define POOL_COUNT  (1 << 17)       // sparse states the adversarial set is picked from
+#define MAX_RESULTS 256
+#define MAX_LENGTH_BENCH 65         // 1 + at most 64 steps that fill a cell
+
+// ------------------------------
+// Timing
+// ------------------------------
+typedef struct {
+    struct timespec time;
+    uint64_t tsc;
+} Stamp;
+
+static inline uint64_t readTsc(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static Stamp stampNow(void) {
+    Stamp s;
+    clock_gettime(CLOCK_MONOTONIC, &s.time);
+    s.tsc = readTsc();
+    return s;
+}
+
+static double secondsBetween(const Stamp *a, const Stamp *b) {
+    return (double)(b->time.tv_sec - a->time.tv_sec) + 1e-9 * (double)(b->time.tv_nsec - a->time.tv_nsec);
+}
+
+// ------------------------------
+// Kernels under test
+//
+// Each one processes the whole input once, adds the generations it
+// computed to *steps (0 for kernels that do not step) and returns a
+// checksum so the work cannot be optimized away.
+// ------------------------------
+typedef uint64_t (*BenchFn)(const uint64_t *states, size_t count, uint64_t *steps);
+
+static uint64_t benchStepReference(const uint64_t *states, size_t count, uint64_t *steps) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t s = states[i];
+        int length = 1;
+        while (iteration_step_reference(&s))
+            length++;
+        sum += (uint64_t)length;
+    }
+    *steps += sum;
+    return sum;
+}
+
+static uint64_t benchComputeLength(const uint64_t *states, size_t count, uint64_t *steps) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++)
+        sum += (uint64_t)water_length(&g_ctx, states[i]);
+    *steps += sum;
+    return sum;
+}
+
+static uint64_t runBatch(WaterIsa isa, int specialised, const uint64_t *states, size_t count,
+                         uint64_t *steps) {
+    WaterBatchKernel kernel = water_batchKernel(g_n, isa, specialised);
+    int lengths[WATER_BATCH_SIZE];
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i += WATER_BATCH_SIZE) {
+        size_t chunk = (count - i < WATER_BATCH_SIZE) ? count - i : WATER_BATCH_SIZE;
+        kernel(&g_ctx, states + i, lengths, chunk);
+        for (size_t k = 0; k < chunk; k++)
+            sum += (uint64_t)lengths[k];
+    }
+    *steps += sum;
+    return sum;
+}
+
+static uint64_t benchBatchScalar(const uint64_t *states, size_t count, uint64_t *steps) {
+    return runBatch(WATER_SCALAR, 0, states, count, steps);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+static uint64_t benchBatchAvx2(const uint64_t *states, size_t count, uint64_t *steps) {
+    return runBatch(WATER_AVX2, 0, states, count, steps);
+}
+
+static uint64_t benchBatchAvx512(const uint64_t *states, size_t count, uint64_t *steps) {
+    return runBatch(WATER_AVX512, 0, states, count, steps);
+}
+#endif
+
+static uint64_t benchBatchScalarFixed(const uint64_t *states, size_t count, uint64_t *steps) {
+    return runBatch(WATER_SCALAR, 1, states, count, steps);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+static uint64_t benchBatchAvx2Fixed(const uint64_t *states, size_t count, uint64_t *steps) {
+    return runBatch(WATER_AVX2, 1, states, count, steps);
+}
+
+static uint64_t benchBatchAvx512Fixed(const uint64_t *states, size_t count, uint64_t *steps) {
+    return runBatch(WATER_AVX512, 1, states, count, steps);
+}
+#endif
+
+static uint64_t runCanonical(int specialised, const uint64_t *states, size_t count) {
+    WaterCanonicalKernel kernel = water_canonicalKernel(g_n, specialised);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        int stabilizer;
+        sum += kernel(&g_ctx, states[i], &stabilizer) + (uint64_t)stabilizer;
+    }
+    return sum;
+}
+
+static uint64_t benchCanonicalFrame(const uint64_t *states, size_t count, uint64_t *steps) {
+    (void)steps;
+    return runCanonical(0, states, count);
+}
+
+static uint64_t benchCanonicalFrameFixed(const uint64_t *states, size_t count, uint64_t *steps) {
+    (void)steps;
+    return runCanonical(1, states, count);
+}
+
+static uint64_t benchCanonicalReference(const uint64_t *states, size_t count, uint64_t *steps) {
+    (void)steps;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t best = states[i];
+        int stabilizer = 1;
+        for (int k = 1; k < 8; k++) {
+            uint64_t image = transformReference(states[i], k);
+            if (image < best)
+                best = image;
+            stabilizer += (image == states[i]);
+        }
+        sum += best + (uint64_t)stabilizer;
+    }
+    return sum;
+}
+
+// ------------------------------
+// End to end: simple.c's main loop (canonical filter + batches) over the
+// first 2^min(n*n, 20) states, in binary or Gray-code order, with the
+// kernels main() would pick (generic or specialised for n). The input set
+// is not used; 'count' states are enumerated.
+// ------------------------------
+static uint64_t runEnumeration(int grayOrder, size_t count, uint64_t *steps) {
+    (void)steps;
+    uint64_t batch[WATER_BATCH_SIZE];
+    size_t batchCount = 0;
+    int maxLength = 0;
+    uint64_t bestState = 0ULL;
+    uint64_t orbitCount = 0ULL;
+    uint64_t state = 0ULL;
+    uint64_t image[8] = {0};
+
+    for (uint64_t i = 0ULL; i < count; i++) {
+        int stabilizer;
+        int isCanonical;
+        if (grayOrder) {
+            if (i > 0) {
+                int c = __builtin_ctzll(i);
+                state ^= 1ULL << c;
+                water_grayFlip(&g_ctx, image, c);
+            }
+            isCanonical = (water_minImage(image, &stabilizer) == image[0]);
+        } else {
+            state = i;
+            isCanonical = (water_canonical(&g_ctx, state, &stabilizer) == state);
+        }
+        if (!isCanonical)
+            continue;
+        orbitCount++;
+        batch[batchCount++] = state;
+        if (batchCount == WATER_BATCH_SIZE) {
+            evaluateBatch(batch, batchCount, &maxLength, &bestState);
+            batchCount = 0;
+        }
+    }
+    if (batchCount)
+        evaluateBatch(batch, batchCount, &maxLength, &bestState);
+    return orbitCount * 64 + (uint64_t)maxLength;
+}
+
+static uint64_t benchEnumerateBinary(const uint64_t *states, size_t count, uint64_t *steps) {
+    (void)states;
+    return runEnumeration(0, count, steps);
+}
+
+static uint64_t benchEnumerateGray(const uint64_t *states, size_t count, uint64_t *steps) {
+    (void)states;
+    return runEnumeration(1, count, steps);
+}
+
+// ------------------------------
+// Inputs
+// ------------------------------
+static void makeRandomInput(uint64_t *states, uint64_t *rng) {
+    for (size_t i = 0; i < INPUT_COUNT; i++)
+        states[i] = xorshift64(rng) & g_ctx.boardMask;
+}
+
+// The INPUT_COUNT longest states of a pool of sparse random states
+static void makeAdversarialInput(uint64_t *states, uint64_t *rng) {
+    uint64_t *pool = (uint64_t *)malloc(sizeof(uint64_t) * POOL_COUNT);
+    int *lengths = (int *)malloc(sizeof(int) * POOL_COUNT);
+    int cells = g_n * g_n;
+    for (size_t i = 0; i < POOL_COUNT; i++) {
+        int k = g_n - 1 + (int)(xorshift64(rng) % 4);
+        uint64_t s = 0ULL;
+        for (int c = 0; c < k; c++)
+            water_fillCell(&s, (int)(xorshift64(rng) % (uint64_t)cells));
+        pool[i] = s;
+        lengths[i] = water_length(&g_ctx, s);
+    }
+
+    // Counting sort by length, longest first
+    size_t byLength[MAX_LENGTH_BENCH + 1] = {0};
+    for (size_t i = 0; i < POOL_COUNT; i++)
+        byLength[lengths[i]]++;
+    int threshold = MAX_LENGTH_BENCH;
+    size_t taken = 0;
+    while (threshold > 1 && taken + byLength[threshold] < INPUT_COUNT)
+        taken += byLength[threshold--];
+    size_t out = 0;
+    for (size_t i = 0; i < POOL_COUNT && out < INPUT_COUNT; i++) {
+        if (lengths[i] >= threshold)
+            states[out++] = pool[i];
+    }
+    free(pool);
+    free(lengths);
+}
+
+// ------------------------------
+// Results
+// ------------------------------
+typedef struct {
+    const char *kernel;
+    const char *variant;
+    const char *input;
+    int n;
+    uint64_t states;
+    uint64_t steps;
+    double seconds;
+    uint64_t tscTicks;
+    uint64_t checksum;
+} Result;
+
+static Result g_results[MAX_RESULTS];
+static int g_resultCount = 0;
+
+static void measure(const char *kernel, const char *variant, const char *input,
+                    BenchFn fn, const uint64_t *states, size_t count, double minSeconds) {
+    uint64_t steps = 0, checksum = 0, passes = 0;
+    fn(states, count, &steps);              // warm up caches and branch predictors
+    steps = 0;
+
+    Stamp start = stampNow(), end;
+    do {
+        checksum = fn(states, count, &steps);
+        passes++;
+        end = stampNow();
+    } while (secondsBetween(&start, &end) < minSeconds);
+
+    if (g_resultCount == MAX_RESULTS)
+        return;
+    Result *r = &g_results[g_resultCount++];
+    r->kernel = kernel;
+    r->variant = variant;
+    r->input = input;
+    r->n = g_n;
+    r->states = passes * (uint64_t)count;
+    r->steps = steps;
+    r->seconds = secondsBetween(&start, &end);
+    r->tscTicks = end.tsc - start.tsc;
+    r->checksum = checksum;
+
+    // stderr, so stdout carries nothing but the JSON when --out is absent
+    fprintf(stderr, "n = %d  %-15s %-12s %-12s %12.4g states/s", g_n, kernel, variant, input,
+            (double)r->states / r->seconds);
+    if (steps)
+        fprintf(stderr, "  %7.3f ns/step", 1e9 * r->seconds / (double)steps);
+    fprintf(stderr, "\n");
+}
+
+static void writeJson(FILE *f) {
+    fprintf(f, "{\n  \"benchmark\": \"water-problem kernels\",\n  \"version\": 1,\n");
+#if defined(__x86_64__) || defined(__i386__)
+    fprintf(f, "  \"cpu\": {\"avx2\": %s, \"avx512f\": %s},\n",
+            __builtin_cpu_supports("avx2") ? "true" : "false",
+            __builtin_cpu_supports("avx512f") ? "true" : "false");
+#endif
+#ifdef __VERSION__
+    fprintf(f, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    fprintf(f, "  \"results\": [\n");
+    for (int i = 0; i < g_resultCount; i++) {
+        const Result *r = &g_results[i];
+        fprintf(f, "    {\"kernel\": \"%s\", \"variant\": \"%s\", \"input\": \"%s\", \"n\": %d, "
+                   "\"states\": %" PRIu64 ", \"steps\": %" PRIu64 ", \"seconds\": %.6f, "
+                   "\"states_per_sec\": %.6g, ",
+                r->kernel, r->variant, r->input, r->n, r->states, r->steps, r->seconds,
+                (double)r->states / r->seconds);
+        if (r->steps)
+            fprintf(f, "\"ns_per_step\": %.4f, ", 1e9 * r->seconds / (double)r->steps);
+        else
+            fprintf(f, "\"ns_per_step\": null, ");
+        if (r->tscTicks)
+            fprintf(f, "\"cycles_per_state\": %.3f, ", (double)r->tscTicks / (double)r->states);
+        else
+            fprintf(f, "\"cycles_per_state\": null, ");
+        fprintf(f, "\"checksum\": %" PRIu64 "}%s\n", r->checksum, (i + 1 < g_resultCount) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+int main(int argc, char **argv) {
+    int nMin = 4, nMax = 8;
+    double minSeconds = 0.2;
+    const char *outPath = NULL;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--n-min") == 0 && a + 1 < argc) {
+            nMin = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--n-max") == 0 && a + 1 < argc) {
+            nMax = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--seconds") == 0 && a + 1 < argc) {
+            minSeconds = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--out") == 0 && a + 1 < argc) {
+            outPath = argv[++a];
+        } else {
+            printf("Usage: %s [--n-min N] [--n-max N] [--seconds S] [--out FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (nMin < 1 || nMax > 8 || nMin > nMax) {
+        printf("n must satisfy 1 <= n-min <= n-max <= 8.\n");
+        return 1;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    int haveAvx2 = __builtin_cpu_supports("avx2");
+    int haveAvx512 = __builtin_cpu_supports("avx512f");
+#endif
+
+    static uint64_t randomInput[INPUT_COUNT], adversarialInput[INPUT_COUNT];
+    for (g_n = nMin; g_n <= nMax; g_n++) {
+        water_init(&g_ctx, g_n, 0);
+
+        // The same inputs every run, whatever the range of n
+        uint64_t rng = 0x9E3779B97F4A7C15ULL ^ (uint64_t)g_n;
+        makeRandomInput(randomInput, &rng);
+        makeAdversarialInput(adversarialInput, &rng);
+
+        for (int in = 0; in < 2; in++) {
+            const char *input = in ? "adversarial" : "random";
+            const uint64_t *states = in ? adversarialInput : randomInput;
+            measure("step", "per-cell", input, benchStepReference, states, INPUT_COUNT, minSeconds);
+            measure("compute_length", "whole-board", input, benchComputeLength, states, INPUT_COUNT, minSeconds);
+            measure("batch", "scalar", input, benchBatchScalar, states, INPUT_COUNT, minSeconds);
+            measure("batch", "scalar-fixed", input, benchBatchScalarFixed, states, INPUT_COUNT, minSeconds);
+#if defined(__x86_64__) || defined(__i386__)
+            if (haveAvx2) {
+                measure("batch", "avx2", input, benchBatchAvx2, states, INPUT_COUNT, minSeconds);
+                measure("batch", "avx2-fixed", input, benchBatchAvx2Fixed, states, INPUT_COUNT, minSeconds);
+            }
+            if (haveAvx512) {
+                measure("batch", "avx512", input, benchBatchAvx512, states, INPUT_COUNT, minSeconds);
+                measure("batch", "avx512-fixed", input, benchBatchAvx512Fixed, states, INPUT_COUNT, minSeconds);
+            }
+#endif
+            measure("canonical", "frame", input, benchCanonicalFrame, states, INPUT_COUNT, minSeconds);
+            measure("canonical", "frame-fixed", input, benchCanonicalFrameFixed, states, INPUT_COUNT, minSeconds);
+            measure("canonical", "per-cell", input, benchCanonicalReference, states, INPUT_COUNT, minSeconds);
+        }
+
+        size_t enumerated = (size_t)1 << ((g_n * g_n < 20) ? g_n * g_n : 20);
+        water_init(&g_ctx, g_n, WATER_GENERIC);
+        measure("enumerate", "binary", "prefix", benchEnumerateBinary, NULL, enumerated, minSeconds);
+        measure("enumerate", "gray", "prefix", benchEnumerateGray, NULL, enumerated, minSeconds);
+        water_init(&g_ctx, g_n, 0);
+        measure("enumerate", "binary-fixed", "prefix", benchEnumerateBinary, NULL, enumerated, minSeconds);
+        measure("enumerate", "gray-fixed", "prefix", benchEnumerateGray, NULL, enumerated, minSeconds);
+    }
+
+    if (outPath) {
+        FILE *f = fopen(outPath, "w");
+        if (!f) {
+            printf("Could not write %s\n", outPath);
+            return 1;
+        }
+        writeJson(f);
+        fclose(f);
+        printf("Wrote %d results to %s\n", g_resultCount, outPath);
+    } else {
+        writeJson(stdout);
+    }
+    return 0;
+}
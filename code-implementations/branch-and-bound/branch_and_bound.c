@@ -0,0 +1,472 @@
+/*
+  Branch-and-bound search for f(n).
+
+  Initial cells are placed one at a time in increasing cell index, like
+  the recursion in marco.c, so every node of the search tree is itself a
+  starting state. A subtree is cut off as soon as no state in it can be
+  longer than the best length found so far. All bounds used are sound, so
+  the search is exact:
+
+  - Root symmetry breaking: of the 8 images of a state we only search the
+    one whose lowest cell index is smallest. If that lowest cell is c0,
+    every other cell c must satisfy min over symmetries g of g(c) >= c0,
+    so each first cell comes with a fixed mask of allowed cells.
+
+  - Bounding box: water never leaves the bounding box of the initial cells,
+    and every step that changes anything fills at least one new cell, so
+    length <= 1 + (bounding box area) - (number of initial cells).
+
+  - Perimeter: a cell that fills has at least two filled neighbours, so
+    filling it changes the perimeter by 4 - 2 * (filled neighbours) <= 0;
+    the perimeter never increases. The final state is a union of
+    rectangles, so its area is at most that of the best rectangle whose
+    perimeter does not exceed the initial one. Each extra initial cell adds
+    at most 4 to the perimeter.
+
+  - Closure: adding initial cells never delays a cell, so for any
+    extension T of a node S every cell S fills is filled by time length(S)-1.
+    After that each changing step must fill a cell S never fills but T can,
+    so length(T) <= length(S) + |closure(S + all allowed later cells)
+    minus closure(S)|.
+
+  - Dominance: if some initial cell d would be filled by the others anyway
+    (d lies in closure(T - d)), removing d keeps the closure and can only
+    make cells fill later, so T is never longer than T - d. The same holds
+    for every extension of T, so such a subtree is skipped. We test the
+    cheap cases: a new cell inside closure(S), or any cell of S + c with
+    two or more neighbours in S + c.
+
+  Usage: branch_and_bound [--threads N] [--lower-bound L]
+  With --lower-bound L only states longer than L are looked for, which is
+  how a known lower bound (e.g. f(7) >= 31) is turned into an upper bound.
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>  // For C11 atomics
+
+#ifdef _WIN32
+#include <windows.h>  // for Sleep(), GetSystemInfo()
+#else
+#include <unistd.h>   // for sysconf() on Linux/macOS
+#endif
+
+#include "../core/water.h"
+
+// ---------------------------------------------------------------------
+// Global variables
+// ---------------------------------------------------------------------
+static int g_n = 0;               // Board size, read from user
+static WaterContext g_ctx;        // masks and kernels for g_n
+
+// Cells with at least two neighbours in 'state'
+static inline uint64_t atLeastTwoNeighbours(uint64_t s) {
+    uint64_t left  = (s << 1) & g_ctx.notFirstCol;
+    uint64_t right = (s >> 1) & g_ctx.notLastCol;
+    uint64_t up    = s << g_n;
+    uint64_t down  = s >> g_n;
+    return ((left & right) | (up & down) | ((left | right) & (up | down))) & g_ctx.boardMask;
+}
+
+// ---------------------------------------------------------------------
+// Length of a state; the final (stable) state is returned in *closure
+// ---------------------------------------------------------------------
+static inline int compute_length(uint64_t initialState, uint64_t *closure) {
+    uint64_t state = initialState;
+    int steps = 1;
+    while (water_step(&g_ctx, &state)) {
+        steps++;
+    }
+    *closure = state;
+    return steps;
+}
+
+// ---------------------------------------------------------------------
+// Tables for the bounds
+// ---------------------------------------------------------------------
+static uint64_t g_allowed[64];           // allowed cells once c0 is the first
+static int g_maxArea[4 * 64 + 1];        // best rectangle area by perimeter
+
+// Symmetry k applied to cell (x,y): bit 0 mirrors, bit 1 flips the rows,
+// bit 2 transposes (k = 0 is the identity)
+static int transformCell(int c, int k) {
+    int x = c % g_n, y = c / g_n;
+    if (k & 1) x = g_n - 1 - x;
+    if (k & 2) y = g_n - 1 - y;
+    if (k & 4) { int t = x; x = y; y = t; }
+    return water_cellIndex(&g_ctx, x, y);
+}
+
+static void buildTables(void) {
+    int cells = g_n * g_n;
+    int orbitMin[64];
+
+    for (int c = 0; c < cells; c++) {
+        orbitMin[c] = c;
+        for (int k = 1; k < 8; k++) {
+            int image = transformCell(c, k);
+            if (image < orbitMin[c])
+                orbitMin[c] = image;
+        }
+    }
+
+    // c0 can only be the first cell if it is the smallest of its orbit;
+    // g_allowed[c0] stays empty otherwise
+    for (int c0 = 0; c0 < cells; c0++) {
+        g_allowed[c0] = 0ULL;
+        if (orbitMin[c0] != c0)
+            continue;
+        for (int c = c0; c < cells; c++) {
+            if (orbitMin[c] >= c0)
+                g_allowed[c0] |= 1ULL << c;
+        }
+    }
+
+    // Largest a*b with a, b <= n and 2(a + b) <= perimeter
+    for (int p = 0; p <= 4 * cells; p++) {
+        g_maxArea[p] = 0;
+        for (int a = 1; a <= g_n; a++) {
+            int b = p / 2 - a;
+            if (b > g_n) b = g_n;
+            if (b >= 1 && a * b > g_maxArea[p])
+                g_maxArea[p] = a * b;
+        }
+    }
+}
+
+// Area of the bounding box of a nonempty mask
+static int boundingBoxArea(uint64_t mask) {
+    unsigned cols = 0u;
+    int top = -1, bottom = -1;
+    unsigned rowMask = (1u << g_n) - 1u;
+    for (int y = 0; y < g_n; y++) {
+        unsigned row = (unsigned)(mask >> (y * g_n)) & rowMask;
+        if (row) {
+            if (top < 0) top = y;
+            bottom = y;
+            cols |= row;
+        }
+    }
+    if (top < 0)
+        return 0;
+    int left = __builtin_ctz(cols);
+    int right = 31 - __builtin_clz(cols);
+    return (bottom - top + 1) * (right - left + 1);
+}
+
+// ---------------------------------------------------------------------
+// Shared best length. Only ever raised, so any thread may prune against
+// whatever value it reads.
+// ---------------------------------------------------------------------
+static _Atomic int g_bestLength;
+
+static void raiseBest(int length) {
+    int current = atomic_load_explicit(&g_bestLength, memory_order_relaxed);
+    while (length > current &&
+           !atomic_compare_exchange_weak(&g_bestLength, &current, length))
+        ;
+}
+
+// ---------------------------------------------------------------------
+// SearchTask struct: one per worker thread
+// ---------------------------------------------------------------------
+typedef struct {
+    _Alignas(64) _Atomic uint64_t nodes;   // read by the progress thread
+    int localMaxLength;
+    uint64_t localBestState;
+    uint64_t allowed;                      // g_allowed of the current job
+} SearchTask;
+
+// Upper bound on the length of any state that extends 'state' by one or
+// more allowed cells after 'last'
+static int childBound(uint64_t state, int cells, int perimeter,
+                      uint64_t later, int length, uint64_t closure) {
+    int area = boundingBoxArea(state | later);
+
+    // Bounding box: at least cells + 1 initial cells
+    int bound = area - cells;
+
+    // Perimeter: with f more cells the final area is at most
+    // min(area, g_maxArea[perimeter + 4f]); the best f is the first one
+    // that reaches the bounding box, or the last one before it
+    int perimeterBound = 0;
+    for (int f = 1; cells + f <= g_n * g_n; f++) {
+        int p = perimeter + 4 * f;
+        int reach = (p > 4 * g_n * g_n) ? area : g_maxArea[p];
+        if (reach > area) reach = area;
+        if (1 + reach - cells - f > perimeterBound)
+            perimeterBound = 1 + reach - cells - f;
+        if (reach == area)
+            break;
+    }
+    if (perimeterBound < bound)
+        bound = perimeterBound;
+
+    // Closure: only cells outside closure(state) can fill after length - 1
+    int closureBound = length + water_popcount(g_ctx.boardMask & ~closure);
+    if (closureBound < bound) {
+        bound = closureBound;
+    } else {
+        uint64_t reachable;
+        compute_length(state | later, &reachable);
+        closureBound = length + water_popcount(reachable & ~closure);
+        if (closureBound < bound)
+            bound = closureBound;
+    }
+    return bound;
+}
+
+static void search(SearchTask* task, uint64_t state, int last, int cells, int perimeter) {
+    uint64_t closure;
+    int length = compute_length(state, &closure);
+    atomic_store_explicit(&task->nodes,
+                          atomic_load_explicit(&task->nodes, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+
+    if (length > task->localMaxLength) {
+        task->localMaxLength = length;
+        task->localBestState = state;
+    }
+    raiseBest(length);
+
+    if (last == 63)
+        return;
+    uint64_t later = task->allowed & ~((2ULL << last) - 1ULL);
+    if (later == 0ULL)
+        return;
+    int best = atomic_load_explicit(&g_bestLength, memory_order_relaxed);
+    if (childBound(state, cells, perimeter, later, length, closure) <= best)
+        return;
+
+    // A new cell inside closure(state) is dominated
+    later &= ~closure;
+    while (later) {
+        int c = __builtin_ctzll(later);
+        later &= later - 1ULL;
+        uint64_t child = state | (1ULL << c);
+        if (atLeastTwoNeighbours(child) & child)
+            continue;
+        int p = perimeter + 4 - 2 * water_popcount(g_ctx.neighborMask[c] & state);
+        search(task, child, c, cells + 1, p);
+    }
+}
+
+// ---------------------------------------------------------------------
+// Jobs: the first JOB_CELLS cells of a state, with the same dominance
+// tests as the search. Shorter prefixes are evaluated while collecting.
+// Workers take jobs in order.
+// ---------------------------------------------------------------------
+#define JOB_CELLS 3
+
+typedef struct {
+    uint64_t state;
+    int first;
+    int last;
+    int cells;
+    int perimeter;
+} Job;
+
+static Job* g_jobs = NULL;
+static int g_jobCount = 0;
+static int g_jobCapacity = 0;
+static _Atomic int g_nextJob;
+static _Atomic int g_jobsDone;
+
+static int g_prefixMaxLength = 1;         // best over the prefixes themselves
+static uint64_t g_prefixBestState = 0ULL;
+
+static void collectJobs(uint64_t state, int first, int last, int cells, int perimeter) {
+    if (cells == JOB_CELLS) {
+        if (g_jobCount == g_jobCapacity) {
+            g_jobCapacity = g_jobCapacity ? 2 * g_jobCapacity : 1024;
+            g_jobs = (Job*)realloc(g_jobs, sizeof(Job) * (size_t)g_jobCapacity);
+        }
+        Job job = { state, first, last, cells, perimeter };
+        g_jobs[g_jobCount++] = job;
+        return;
+    }
+
+    uint64_t closure;
+    int length = compute_length(state, &closure);
+    if (length > g_prefixMaxLength) {
+        g_prefixMaxLength = length;
+        g_prefixBestState = state;
+    }
+
+    for (int c = last + 1; c < g_n * g_n; c++) {
+        if (cells == 0)
+            first = c;
+        uint64_t allowed = g_allowed[first] & ~closure;
+        if (!water_isFilled(allowed, c))
+            continue;
+        uint64_t child = state | (1ULL << c);
+        if (atLeastTwoNeighbours(child) & child)
+            continue;
+        int p = perimeter + 4 - 2 * water_popcount(g_ctx.neighborMask[c] & state);
+        collectJobs(child, first, c, cells + 1, p);
+    }
+}
+
+void* workerThreadFunc(void* arg) {
+    SearchTask* task = (SearchTask*)arg;
+
+    int j;
+    while ((j = atomic_fetch_add(&g_nextJob, 1)) < g_jobCount) {
+        const Job* job = &g_jobs[j];
+        task->allowed = g_allowed[job->first];
+        search(task, job->state, job->last, job->cells, job->perimeter);
+        atomic_fetch_add(&g_jobsDone, 1);
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------
+// Progress thread function
+// ---------------------------------------------------------------------
+typedef struct {
+    SearchTask* tasks;
+    int threadCount;
+    _Atomic int doneFlag;
+} ProgressTask;
+
+static void sleepMillis(int ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static double secondsSince(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + 1e-9 * (double)(now.tv_nsec - start->tv_nsec);
+}
+
+void* progressThreadFunc(void* arg) {
+    ProgressTask* pt = (ProgressTask*)arg;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int ticks = 0;
+    while (!atomic_load(&pt->doneFlag)) {
+        // Poll often so we exit promptly, but only print every 10 seconds
+        sleepMillis(100);
+        if (++ticks % 100 != 0)
+            continue;
+
+        uint64_t nodes = 0;
+        for (int i = 0; i < pt->threadCount; i++)
+            nodes += atomic_load_explicit(&pt->tasks[i].nodes, memory_order_relaxed);
+        double elapsed = secondsSince(&start);
+        printf("Progress: %d / %d jobs, best %d, %llu nodes (%.3g nodes/s)\n",
+               atomic_load(&g_jobsDone), g_jobCount,
+               atomic_load(&g_bestLength),
+               (unsigned long long)nodes,
+               elapsed > 0.0 ? (double)nodes / elapsed : 0.0);
+    }
+    return NULL;
+}
+
+static int defaultThreadCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+#endif
+}
+
+// ---------------------------------------------------------------------
+// main()
+// ---------------------------------------------------------------------
+int main(int argc, char **argv) {
+    int threadCount = defaultThreadCount();
+    int lowerBound = 0;
+    for (int a = 1; a < argc; a++) {
+        if ((strcmp(argv[a], "--threads") == 0 || strcmp(argv[a], "-t") == 0) && a + 1 < argc) {
+            threadCount = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--lower-bound") == 0 && a + 1 < argc) {
+            lowerBound = atoi(argv[++a]);
+        } else {
+            printf("Usage: %s [--threads N] [--lower-bound L]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (threadCount < 1) {
+        printf("Thread count must be at least 1.\n");
+        return 1;
+    }
+
+    printf("Enter grid size (1 to 8): ");
+    if (scanf("%d", &g_n) != 1 || g_n < 1 || g_n > 8) {
+        printf("Invalid input.\n");
+        return 1;
+    }
+
+    water_init(&g_ctx, g_n, 0);
+    buildTables();
+    collectJobs(0ULL, 0, -1, 0, 0);
+    printf("Jobs: %d, threads: %d\n", g_jobCount, threadCount);
+
+    atomic_init(&g_bestLength, lowerBound > g_prefixMaxLength ? lowerBound : g_prefixMaxLength);
+    atomic_init(&g_nextJob, 0);
+    atomic_init(&g_jobsDone, 0);
+
+    SearchTask* tasks = (SearchTask*)aligned_alloc(_Alignof(SearchTask), sizeof(SearchTask) * threadCount);
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        atomic_init(&tasks[i].nodes, 0ULL);
+        tasks[i].localMaxLength = 1;
+        tasks[i].localBestState = 0ULL;
+        tasks[i].allowed = 0ULL;
+    }
+
+    ProgressTask ptask;
+    ptask.tasks = tasks;
+    ptask.threadCount = threadCount;
+    atomic_init(&ptask.doneFlag, 0);
+    pthread_t progressThread;
+    pthread_create(&progressThread, NULL, progressThreadFunc, &ptask);
+
+    for (int i = 0; i < threadCount; i++) {
+        pthread_create(&threads[i], NULL, workerThreadFunc, &tasks[i]);
+    }
+
+    int globalMaxLength = g_prefixMaxLength;
+    uint64_t globalBestState = g_prefixBestState;
+    uint64_t nodes = 0;
+    for (int i = 0; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+        nodes += atomic_load(&tasks[i].nodes);
+        if (tasks[i].localMaxLength > globalMaxLength) {
+            globalMaxLength = tasks[i].localMaxLength;
+            globalBestState = tasks[i].localBestState;
+        }
+    }
+
+    atomic_store(&ptask.doneFlag, 1);
+    pthread_join(progressThread, NULL);
+
+    printf("Nodes = %llu\n", (unsigned long long)nodes);
+    if (globalMaxLength <= lowerBound) {
+        printf("No state is longer than %d, so f(%d) <= %d\n", lowerBound, g_n, lowerBound);
+    } else {
+        printf("Max length = %d\n", globalMaxLength);
+        printf("Best state = %" PRIu64 "\n", globalBestState);
+        water_print(&g_ctx, globalBestState);
+    }
+
+    free(threads);
+    free(tasks);
+    free(g_jobs);
+    return 0;
+}
@@ -7,270 +7,2247 @@
 #include <time.h>
 #include <pthread.h>
 #include <stdatomic.h>  // For C11 atomics
+#include <stdarg.h>
 
 #ifdef _WIN32
-#include <windows.h>  // for Sleep()
+#include <windows.h>  // for Sleep(), GetSystemInfo()
 #else
-#include <unistd.h>   // for sleep() on Linux/macOS
+#include <unistd.h>   // for sysconf(), fsync() on Linux/macOS
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>   // for SIGPIPE where send() has no MSG_NOSIGNAL
+#include <sys/file.h> // for flock() on shard locks
+#include <sys/stat.h>
+#include <sys/socket.h>   // for telemetry over a Unix socket
+#include <sys/un.h>
+#include <sys/wait.h>     // for the self-check's child processes
+#include <dirent.h>
 #endif
 
+#include "../core/water.h"
+
 // ---------------------------------------------------------------------
 // Global variables
 // ---------------------------------------------------------------------
 static int g_n = 0;               // Board size, read from user
-static uint64_t neighborMask[64]; // Precomputed neighbor masks
-static _Atomic uint64_t processed_count = 0; // How many states have been processed
+static WaterContext g_ctx;        // Masks and kernels for g_n
 
 // ---------------------------------------------------------------------
-// Popcount (bit count). If your compiler doesn't have __builtin_popcountll,
-// you can implement a custom bit-count.
+// Orbit-ordered generation of canonical states
+//
+// Cells are grouped into their orbits under the 8 symmetries of the square
+// (orbits of 8, 4 or 1 cells). A state is read as a string of orbit
+// "blocks", most significant block first, and its canonical representative
+// is the image that is smallest in that order. Because every symmetry maps
+// each orbit onto itself, deciding the blocks one at a time lets us compare
+// a partial state with each of its images exactly:
+//   - block > image block: no completion is canonical, prune the subtree
+//   - block < image block: this symmetry can never win, drop it
+//   - equal: keep checking it on the next block
+// Once every symmetry has been dropped, all completions are canonical and
+// are generated directly (in Gray-code order over the remaining cells).
+// Non-canonical states are never produced, so the workers only ever see
+// orbit representatives. Symmetries that survive to the last block fix the
+// state, which gives the stabilizer size and so the orbit size.
 // ---------------------------------------------------------------------
-static inline int popcount64(uint64_t x) {
-    return __builtin_popcountll(x);
+#define MAX_ORBITS 16
+
+static int g_orbitCount = 0;
+static int g_orbitSize[MAX_ORBITS];
+static uint64_t g_orbitBlockState[MAX_ORBITS][256];   // block pattern -> cells
+static uint8_t g_orbitImage[MAX_ORBITS][8][256];      // pattern under symmetry g
+static int g_freeCellCount[MAX_ORBITS + 1];           // cells in orbits o..end
+static int g_freeCells[MAX_ORBITS + 1][64];
+
+// Symmetry k applied to cell (x,y): bit 0 mirrors, bit 1 flips the rows,
+// bit 2 transposes (k = 0 is the identity)
+static int transformCell(int c, int k) {
+    int x = c % g_n, y = c / g_n;
+    if (k & 1) x = g_n - 1 - x;
+    if (k & 2) y = g_n - 1 - y;
+    if (k & 4) { int t = x; x = y; y = t; }
+    return water_cellIndex(&g_ctx, x, y);
+}
+
+static void buildOrbits(void) {
+    int cells = g_n * g_n;
+    int orbitOf[64];
+    int members[64][8];
+    int memberCount[64];
+    int found = 0;
+
+    for (int c = 0; c < cells; c++)
+        orbitOf[c] = -1;
+    for (int c = 0; c < cells; c++) {
+        if (orbitOf[c] >= 0)
+            continue;
+        memberCount[found] = 0;
+        for (int k = 0; k < 8; k++) {
+            int d = transformCell(c, k);
+            if (orbitOf[d] < 0) {
+                orbitOf[d] = found;
+                members[found][memberCount[found]++] = d;
+            }
+        }
+        found++;
+    }
+
+    // Big orbits first: they decide the most symmetries per level
+    g_orbitCount = 0;
+    for (int size = 8; size >= 1; size--) {
+        for (int o = 0; o < found; o++) {
+            if (memberCount[o] != size)
+                continue;
+            int dst = g_orbitCount++;
+            g_orbitSize[dst] = size;
+            for (unsigned v = 0; v < (1u << size); v++) {
+                uint64_t cellsOfV = 0ULL;
+                for (int i = 0; i < size; i++)
+                    if (v & (1u << i))
+                        cellsOfV |= 1ULL << members[o][i];
+                g_orbitBlockState[dst][v] = cellsOfV;
+
+                for (int k = 0; k < 8; k++) {
+                    unsigned image = 0;
+                    for (int i = 0; i < size; i++) {
+                        if (!(v & (1u << i)))
+                            continue;
+                        int d = transformCell(members[o][i], k);
+                        for (int j = 0; j < size; j++)
+                            if (members[o][j] == d)
+                                image |= 1u << j;
+                    }
+                    g_orbitImage[dst][k][v] = (uint8_t)image;
+                }
+            }
+        }
+    }
+
+    for (int o = g_orbitCount; o >= 0; o--) {
+        g_freeCellCount[o] = 0;
+        for (int p = o; p < g_orbitCount; p++)
+            for (int i = 0; i < g_orbitSize[p]; i++)
+                g_freeCells[o][g_freeCellCount[o]++] = __builtin_ctzll(g_orbitBlockState[p][1u << i]);
+    }
 }
 
+// Compare block v of orbit o with its images under the still-undecided
+// symmetries. Returns 0 if the state can't be canonical, otherwise 1 with
+// *unresolved updated.
+static inline int checkBlock(int o, unsigned v, unsigned* unresolved) {
+    unsigned r = *unresolved;
+    for (unsigned m = r; m; m &= m - 1) {
+        int k = __builtin_ctz(m);
+        unsigned image = g_orbitImage[o][k][v];
+        if (v > image)
+            return 0;
+        if (v < image)
+            r &= ~(1u << k);
+    }
+    *unresolved = r;
+    return 1;
+}
+
+#define ALL_SYMMETRIES 0xFEu     // bits 1..7, the identity is bit 0
+
 // ---------------------------------------------------------------------
-// Indexing, fill-check, fill-set
+// Jobs: canonical prefixes covering the first jobDepth orbits
 // ---------------------------------------------------------------------
-static inline int cellIndex(int x, int y) {
-    return y * g_n + x;
+typedef struct {
+    uint64_t state;          // cells of the decided orbits
+    unsigned unresolved;     // symmetries still tied with the identity
+} Job;
+
+static Job* g_jobs = NULL;
+static uint64_t g_jobCount = 0;
+static uint64_t g_jobCapacity = 0;
+static int g_jobDepth = 0;
+
+static void addJob(uint64_t state, unsigned unresolved) {
+    if (g_jobCount == g_jobCapacity) {
+        g_jobCapacity = g_jobCapacity ? 2 * g_jobCapacity : 1024;
+        g_jobs = (Job*)realloc(g_jobs, sizeof(Job) * g_jobCapacity);
+    }
+    g_jobs[g_jobCount].state = state;
+    g_jobs[g_jobCount].unresolved = unresolved;
+    g_jobCount++;
 }
 
-static inline int isFilled(uint64_t state, int idx) {
-    return (state >> idx) & 1ULL;
+static void collectJobs(int o, uint64_t state, unsigned unresolved) {
+    if (o == g_jobDepth) {
+        addJob(state, unresolved);
+        return;
+    }
+    for (unsigned v = 0; v < (1u << g_orbitSize[o]); v++) {
+        unsigned r = unresolved;
+        if (checkBlock(o, v, &r))
+            collectJobs(o + 1, state | g_orbitBlockState[o][v], r);
+    }
 }
 
-static inline void fillCell(uint64_t *state, int idx) {
-    *state |= (1ULL << idx);
+// Rough number of representatives below a job: exact when no symmetry is
+// left undecided, otherwise scaled down by the ones that are still tied
+static double jobWeight(const Job* job) {
+    double w = (double)(1ULL << g_freeCellCount[g_jobDepth]);
+    return w / (double)(1 + __builtin_popcount(job->unresolved));
 }
 
 // ---------------------------------------------------------------------
-// Build neighbor masks for each cell
+// Work-stealing scheduler
+//
+// Each thread owns a range [begin, end) of job indices, packed into one
+// atomic word so it can be updated with a single CAS. The owner takes jobs
+// from the front; a thread whose range is empty steals the back half of
+// another thread's range. A job is handed out exactly once, so a range
+// value never comes back after it has been consumed and the CAS cannot
+// suffer from ABA.
 // ---------------------------------------------------------------------
-static void buildNeighborMasks(void) {
-    memset(neighborMask, 0, sizeof(neighborMask));
-    for (int y = 0; y < g_n; y++) {
-        for (int x = 0; x < g_n; x++) {
-            int c = cellIndex(x, y);
-            // Up
-            if (y > 0)
-                neighborMask[c] |= (1ULL << cellIndex(x, y - 1));
-            // Down
-            if (y < g_n - 1)
-                neighborMask[c] |= (1ULL << cellIndex(x, y + 1));
-            // Left
-            if (x > 0)
-                neighborMask[c] |= (1ULL << cellIndex(x - 1, y));
-            // Right
-            if (x < g_n - 1)
-                neighborMask[c] |= (1ULL << cellIndex(x + 1, y));
-        }
-    }
+static inline uint64_t packRange(uint64_t begin, uint64_t end) {
+    return (begin << 32) | end;
+}
+
+static inline uint64_t rangeBegin(uint64_t r) { return r >> 32; }
+static inline uint64_t rangeEnd(uint64_t r)   { return r & 0xFFFFFFFFULL; }
+
+#define MAX_LENGTH 65            // 1 + at most 64 steps that fill a cell
+#define MAXIMIZER_BUFFER 65536   // states a thread keeps before spilling
+#define CENSUS_CELLS 65          // 0..64 initial cells
+#define PREFILTER_RULES 2
+
+// --census table: census[length * CENSUS_CELLS + cells] counts states
+static inline size_t censusIndex(int length, int cells) {
+    return (size_t)length * CENSUS_CELLS + (size_t)cells;
+}
+#define CENSUS_SIZE ((MAX_LENGTH + 1) * CENSUS_CELLS)
+
+// States of the longest length a thread has seen (--all-maximizers)
+typedef struct {
+    int length;
+    uint64_t count;          // orbits held (buffer + spill)
+    uint64_t raw;            // states those orbits cover
+    size_t used;
+    uint64_t* buffer;        // MAXIMIZER_BUFFER canonical states
+    FILE* spill;             // overflow, opened when the buffer first fills
+} Maximizers;
+
+// ---------------------------------------------------------------------
+// ThreadTask struct: one per worker thread. The fields other threads touch
+// (range, covered, the telemetry counters) each get their own cache line.
+// ---------------------------------------------------------------------
+typedef struct {
+    _Alignas(64) _Atomic uint64_t range;     // packed [begin,end) of g_pending slots
+    _Alignas(64) _Atomic uint64_t covered;   // states covered by the orbits done
+
+    // Telemetry: copies of the local counters below, stored once per batch
+    _Alignas(64) _Atomic uint64_t telOrbits;
+    _Atomic uint64_t telSteps;
+    _Atomic uint64_t telSimNanos;
+    _Atomic uint64_t telPrefilterNanos;
+    _Atomic uint64_t telBusyNanos;
+    _Atomic uint64_t telSkipped;
+    _Atomic int telMaxLength;
+
+    int id;
+    int localMaxLength;
+    uint64_t localBestState;
+    uint64_t localOrbits;
+    uint64_t histogram[MAX_LENGTH + 1];      // states covered, by length
+    uint64_t* census;                        // CENSUS_SIZE counts (--census)
+    Maximizers maximizers;
+    uint64_t skipped[PREFILTER_RULES];       // orbits each prefilter rule skipped
+    int skippedMaxLength;                    // --prefilter-verify
+    uint64_t skippedBestState;
+
+    // the job currently being searched
+    int jobMaxLength;
+    uint64_t jobBestState;
+    uint64_t jobOrbits;
+    uint64_t jobCovered;
+
+    // batch of canonical states waiting for compute_lengths
+    size_t batchCount;
+    uint64_t coveredSoFar;
+    uint64_t orbitsSoFar;                    // evaluated or skipped by the prefilter
+    uint64_t skippedSoFar;                   // skipped by the prefilter
+    uint64_t stepsSoFar;                     // sum of the lengths evaluated
+    uint64_t simNanos;                       // time in compute_lengths (--telemetry)
+    uint64_t prefilterNanos;                 // time in prefilterBatch (--telemetry)
+    uint64_t startNanos;
+
+    // batch kernel by measurement
+    int kernel;                              // index into g_kernels
+    uint64_t kernelBatches;                  // batches since the last trial began
+    uint64_t kernelNanos[3];                 // per candidate, in this trial
+    uint64_t kernelStates[3];
+    uint64_t batch[WATER_BATCH_SIZE];
+    uint8_t batchWeight[WATER_BATCH_SIZE];         // orbit size of each batch entry
+} ThreadTask;
+
+static ThreadTask* g_tasks = NULL;
+static int g_threadCount = 0;
+
+// Set by --telemetry; the workers only time their batches when it is on
+static int g_telemetry = 0;
+
+static inline uint64_t nowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
 }
 
 // ---------------------------------------------------------------------
-// One iteration step. Returns 1 if any cell changed, else 0.
+// Batch kernel by measurement
+//
+// The fastest batch kernel depends on n, the CPU and even the part of the
+// state space being enumerated: the scalar one led AVX2 and AVX-512 by
+// 10-40% at n = 4..7 on Gray-code runs on one machine, yet the whole n = 6
+// run was about 10% faster with AVX-512 there. So each worker times the
+// candidates on its own batches, taking them in turn for a trial of
+// KERNEL_TRIAL_ROUNDS rounds, keeps the one with the fewest ns per state,
+// and repeats the trial every KERNEL_PERIOD_BATCHES batches. The lengths
+// do not depend on the kernel. --kernel ISA pins one and skips the trials.
 // ---------------------------------------------------------------------
-static int iteration_step(uint64_t *state) {
-    uint64_t old_state = *state;
-    int changed = 0;
-    for (int c = 0; c < g_n*g_n; c++) {
-        if (!isFilled(old_state, c)) {
-            int count_neighbors = popcount64(old_state & neighborMask[c]);
-            if (count_neighbors >= 2) {
-                fillCell(state, c);
-                changed = 1;
+#define KERNEL_TRIAL_ROUNDS 32
+#define KERNEL_PERIOD_BATCHES 16384       // about 16M states
+
+static WaterBatchKernel g_kernels[3];
+static WaterIsa g_kernelIsa[3];
+static int g_kernelCount = 0;
+static uint64_t g_kernelTrialBatches = 0;   // 0 with a single candidate
+
+// The candidates for g_ctx: every ISA the CPU has, or only 'pinned' (>= 0).
+// Returns 0 if the pinned one is not available.
+static int setKernels(int pinned) {
+    g_kernelCount = 0;
+    for (int isa = WATER_SCALAR; isa <= WATER_AVX512; isa++) {
+        WaterBatchKernel kernel = water_batchKernel(g_n, (WaterIsa)isa, g_ctx.specialised);
+        if (kernel && (pinned < 0 || pinned == isa)) {
+            g_kernels[g_kernelCount] = kernel;
+            g_kernelIsa[g_kernelCount] = (WaterIsa)isa;
+            g_kernelCount++;
+        }
+    }
+    g_kernelTrialBatches = (g_kernelCount > 1) ? (uint64_t)KERNEL_TRIAL_ROUNDS * g_kernelCount : 0;
+    return g_kernelCount > 0;
+}
+
+// "avx2 (specialised for this n)", or the candidates when measuring
+static const char* kernelDescription(void) {
+    static char text[128];
+    size_t len = 0;
+    for (int k = 0; k < g_kernelCount; k++)
+        len += (size_t)snprintf(text + len, sizeof(text) - len, "%s%s",
+                                k ? (k + 1 < g_kernelCount ? ", " : " or ") : "",
+                                water_isaName(g_kernelIsa[k]));
+    snprintf(text + len, sizeof(text) - len, "%s%s", g_kernelCount > 1 ? " by measurement" : "",
+             g_ctx.specialised ? " (specialised for this n)" : "");
+    return text;
+}
+
+// The candidate for the next batch: each in turn during a trial
+static inline int nextKernel(const ThreadTask* task) {
+    if (task->kernelBatches < g_kernelTrialBatches)
+        return (int)(task->kernelBatches % (uint64_t)g_kernelCount);
+    return task->kernel;
+}
+
+// Accounts one batch of 'states' that kernel k took 'nanos' over (only read
+// during a trial); picks the winner when the trial ends
+static void countKernelBatch(ThreadTask* task, int k, size_t states, uint64_t nanos) {
+    if (task->kernelBatches < g_kernelTrialBatches) {
+        task->kernelNanos[k] += nanos;
+        task->kernelStates[k] += states;
+        if (task->kernelBatches + 1 == g_kernelTrialBatches) {
+            int best = 0;
+            for (int c = 1; c < g_kernelCount; c++) {
+                if ((double)task->kernelNanos[c] * (double)task->kernelStates[best]
+                    < (double)task->kernelNanos[best] * (double)task->kernelStates[c])
+                    best = c;
             }
+            task->kernel = best;
+            memset(task->kernelNanos, 0, sizeof(task->kernelNanos));
+            memset(task->kernelStates, 0, sizeof(task->kernelStates));
         }
     }
-    return changed;
+    if (++task->kernelBatches == KERNEL_PERIOD_BATCHES)
+        task->kernelBatches = 0;
 }
 
 // ---------------------------------------------------------------------
-// Compute the water-fill length for a given initial state
+// Job results
+//
+// A worker fills in a job's result and only then sets 'done' (release), so
+// a reader that sees done == 1 also sees the whole result. This is all the
+// checkpoint writer needs: it never waits for a worker, and workers never
+// wait for it.
+// ---------------------------------------------------------------------
+typedef struct {
+    _Atomic int done;
+    int thread;              // worker that ran it, -1 if done in an earlier run
+    int maxLength;
+    uint64_t bestState;
+    uint64_t covered;        // states covered by the job's orbits
+    uint64_t orbits;         // canonical states evaluated
+} JobResult;
+
+static JobResult* g_jobResults = NULL;
+static uint64_t* g_pending = NULL;    // jobs still to do; ranges index this
+static uint64_t g_pendingCount = 0;
+
+// Totals carried over from the checkpoint we resumed from
+typedef struct {
+    int maxLength;
+    uint64_t bestState;
+    uint64_t covered;
+    uint64_t orbits;
+} Totals;
+
+static Totals g_resumed = { 0, 0ULL, 0ULL, 0ULL };
+
+// ---------------------------------------------------------------------
+// All maximizers
+//
+// With --all-maximizers every thread keeps the states of the longest
+// length seen so far. The threads share only that length, raised with a
+// CAS, so a thread drops its states as soon as any thread has seen a
+// longer one and never takes a lock. Each orbit is generated exactly once,
+// so the states need no deduplication; they are stored as the smallest of
+// their eight images, water_canonical()'s representative. A full buffer
+// is appended to a temporary spill file, which keeps memory at
+// MAXIMIZER_BUFFER states per thread whatever the count.
 // ---------------------------------------------------------------------
-static int compute_length(uint64_t initialState) {
-    uint64_t state = initialState;
-    int steps = 1;
-    while (iteration_step(&state)) {
-        steps++;
+static const char* g_maximizerPath = NULL;
+static _Atomic int g_collectLength;
+
+static void resetMaximizers(Maximizers* mx, int length) {
+    mx->length = length;
+    mx->count = 0;
+    mx->raw = 0;
+    mx->used = 0;
+    if (mx->spill) {
+        fclose(mx->spill);
+        mx->spill = NULL;
+    }
+}
+
+static void noteMaximizer(ThreadTask* task, uint64_t state, int length, int weight) {
+    int best = atomic_load_explicit(&g_collectLength, memory_order_relaxed);
+    while (length > best
+           && !atomic_compare_exchange_weak_explicit(&g_collectLength, &best, length,
+                                                     memory_order_relaxed, memory_order_relaxed))
+        ;
+    if (length > best)
+        best = length;
+
+    Maximizers* mx = &task->maximizers;
+    if (mx->length < best)
+        resetMaximizers(mx, best);
+    if (length < best)
+        return;
+
+    if (mx->used == MAXIMIZER_BUFFER) {
+        if (!mx->spill)
+            mx->spill = tmpfile();
+        if (!mx->spill || fwrite(mx->buffer, sizeof(uint64_t), mx->used, mx->spill) != mx->used) {
+            printf("Could not spill maximizers to a temporary file\n");
+            exit(1);
+        }
+        mx->used = 0;
+    }
+    mx->buffer[mx->used++] = water_canonical(&g_ctx, state, NULL);
+    mx->count++;
+    mx->raw += (uint64_t)weight;
+}
+
+// Write the maximizers of every thread that reached the longest length.
+// File layout (host byte order): the 8 bytes "WPMAXIM1", uint32 n, uint32
+// length, uint64 orbits, uint64 raw states, then one uint64 per orbit.
+static int writeMaximizers(const char* path, uint64_t* orbits, uint64_t* raw) {
+    int length = atomic_load(&g_collectLength);
+    *orbits = 0;
+    *raw = 0;
+    for (int i = 0; i < g_threadCount; i++) {
+        if (g_tasks[i].maximizers.length == length) {
+            *orbits += g_tasks[i].maximizers.count;
+            *raw    += g_tasks[i].maximizers.raw;
+        }
+    }
+
+    FILE* f = fopen(path, "wb");
+    if (!f)
+        return 0;
+    uint32_t header[2] = { (uint32_t)g_n, (uint32_t)length };
+    uint64_t counts[2] = { *orbits, *raw };
+    int ok = fwrite("WPMAXIM1", 1, 8, f) == 8
+          && fwrite(header, sizeof(header), 1, f) == 1
+          && fwrite(counts, sizeof(counts), 1, f) == 1;
+    for (int i = 0; ok && i < g_threadCount; i++) {
+        Maximizers* mx = &g_tasks[i].maximizers;
+        if (mx->length != length)
+            continue;
+        if (mx->spill) {
+            uint64_t chunk[4096];
+            size_t got;
+            rewind(mx->spill);
+            while (ok && (got = fread(chunk, sizeof(uint64_t), 4096, mx->spill)) > 0)
+                ok = fwrite(chunk, sizeof(uint64_t), got, f) == got;
+        }
+        ok = ok && fwrite(mx->buffer, sizeof(uint64_t), mx->used, f) == mx->used;
+    }
+    return (fclose(f) == 0) && ok;
+}
+
+// Take the next job from our own range, stealing when it is empty.
+// Returns 0 once every range is empty.
+static int nextJob(ThreadTask* task, uint64_t* job) {
+    for (;;) {
+        uint64_t r = atomic_load(&task->range);
+        uint64_t b = rangeBegin(r), e = rangeEnd(r);
+        if (b >= e)
+            break;
+        if (atomic_compare_exchange_weak(&task->range, &r, packRange(b + 1, e))) {
+            *job = b;
+            return 1;
+        }
+    }
+
+    for (int k = 1; k < g_threadCount; k++) {
+        ThreadTask* victim = &g_tasks[(task->id + k) % g_threadCount];
+        uint64_t r = atomic_load(&victim->range);
+        for (;;) {
+            uint64_t b = rangeBegin(r), e = rangeEnd(r);
+            if (b >= e)
+                break;
+            uint64_t take = (e - b + 1) / 2;
+            if (atomic_compare_exchange_weak(&victim->range, &r, packRange(b, e - take))) {
+                // keep the first stolen job, the rest becomes our range
+                *job = e - take;
+                atomic_store(&task->range, packRange(e - take + 1, e));
+                return 1;
+            }
+        }
     }
-    return steps;
+    return 0;
 }
 
 // ---------------------------------------------------------------------
-// Printing an n×n state (optional)
+// Dominance prefilter
+//
+// If an initial cell d of T would be filled by the other initial cells
+// anyway (d lies in the closure of T - d), then T - d has the same closure
+// and, being a subset of T, is never ahead of it at any step, so
+// length(T) <= length(T - d). T cannot beat the maximum and is skipped.
+// Each rule is a cheap test for such a d, and every rule is invariant
+// under the 8 symmetries, so the orbit of T - d is still evaluated (or
+// itself skipped in favour of a state with fewer cells, down to one that
+// is evaluated).
+//
+// --prefilter turns the rules on. They run over a whole batch before
+// compute_lengths, the first in a loop the compiler vectorises, and only
+// the states that survive are simulated. Skipped states count as covered
+// and go to bucket 0 of the length histogram; --census and
+// --all-maximizers need every length and do not take the prefilter.
+// --prefilter-verify also simulates the skipped states and fails the run
+// if any of them is longer than the reported maximum.
 // ---------------------------------------------------------------------
-static void printGrid(uint64_t state) {
-    printf("+");
-    for (int i = 0; i < g_n*2 + 1; i++)
-        printf("-");
-    printf("+\n");
+static int g_prefilterRules = 0;          // bit r: rule r is on
+static int g_prefilterVerify = 0;
+static uint64_t g_prefilterSkipped[PREFILTER_RULES];   // orbits, over all runs
+static int g_prefilterSkippedMax = 0;                  // --prefilter-verify
+static uint64_t g_prefilterSkippedState = 0ULL;
+
+// Cells with at least two neighbours in 's'
+static inline uint64_t atLeastTwoNeighbours(uint64_t s) {
+    uint64_t left  = (s << 1) & g_ctx.notFirstCol;
+    uint64_t right = (s >> 1) & g_ctx.notLastCol;
+    uint64_t up    = s << g_n;
+    uint64_t down  = s >> g_n;
+    return ((left & right) | (up & down) | ((left | right) & (up | down))) & g_ctx.boardMask;
+}
+
+// Rule 0: an initial cell has two initial neighbours, so T - d fills it
+// at step 1
+static void ruleTwoNeighbours(const uint64_t* states, uint8_t* dominated, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        dominated[i] |= (atLeastTwoNeighbours(states[i]) & states[i]) != 0;
+}
+
+// Rule 1: T - d fills d by step 2. One pass per initial cell, so it only
+// looks at the states no earlier rule has skipped.
+static void ruleSecondStep(const uint64_t* states, uint8_t* dominated, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (dominated[i])
+            continue;
+        uint64_t s = states[i];
+        for (uint64_t rest = s; rest; rest &= rest - 1) {
+            uint64_t d = rest & (~rest + 1);
+            uint64_t others = s & ~d;
+            uint64_t one = others | atLeastTwoNeighbours(others);
+            if (atLeastTwoNeighbours(one) & d) {
+                dominated[i] = 1;
+                break;
+            }
+        }
+    }
+}
+
+typedef void (*DominanceRule)(const uint64_t* states, uint8_t* dominated, size_t count);
 
-    for (int y = 0; y < g_n; y++) {
-        printf("|");
-        for (int x = 0; x < g_n; x++) {
-            int c = cellIndex(x, y);
-            if (isFilled(state, c)) {
-                printf(" W");
-            } else {
-                printf(" .");
+static const struct {
+    const char* name;
+    DominanceRule apply;
+} g_prefilter[PREFILTER_RULES] = {
+    { "two-neighbours", ruleTwoNeighbours },
+    { "second-step",    ruleSecondStep },
+};
+
+// Parse "all" or a comma-separated list of rule names into g_prefilterRules
+static int parsePrefilter(const char* list) {
+    if (strcmp(list, "all") == 0) {
+        g_prefilterRules = (1 << PREFILTER_RULES) - 1;
+        return 1;
+    }
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", list);
+    for (char* name = strtok(buf, ","); name; name = strtok(NULL, ",")) {
+        int found = 0;
+        for (int r = 0; r < PREFILTER_RULES; r++) {
+            if (strcmp(name, g_prefilter[r].name) == 0) {
+                g_prefilterRules |= 1 << r;
+                found = 1;
             }
         }
-        printf(" |\n");
+        if (!found)
+            return 0;
+    }
+    return g_prefilterRules != 0;
+}
+
+// Drop the dominated states of the batch, keeping the order of the rest
+static void prefilterBatch(ThreadTask* task) {
+    uint8_t dominated[WATER_BATCH_SIZE];    // set to 1 by the rules
+    uint8_t firstRule[WATER_BATCH_SIZE];    // 1 + the first rule that fired
+    memset(dominated, 0, task->batchCount);
+    memset(firstRule, 0, task->batchCount);
+    for (int r = 0; r < PREFILTER_RULES; r++) {
+        if (!(g_prefilterRules & (1 << r)))
+            continue;
+        g_prefilter[r].apply(task->batch, dominated, task->batchCount);
+        for (size_t i = 0; i < task->batchCount; i++) {
+            if (dominated[i] && !firstRule[i])
+                firstRule[i] = (uint8_t)(r + 1);
+        }
+    }
+
+    uint64_t skippedStates[WATER_BATCH_SIZE];
+    size_t kept = 0, skippedCount = 0;
+    for (size_t i = 0; i < task->batchCount; i++) {
+        if (dominated[i]) {
+            task->skipped[firstRule[i] - 1]++;
+            task->histogram[0] += task->batchWeight[i];
+            skippedStates[skippedCount++] = task->batch[i];
+        } else {
+            task->batch[kept] = task->batch[i];
+            task->batchWeight[kept] = task->batchWeight[i];
+            kept++;
+        }
     }
+    task->jobOrbits += skippedCount;
+    task->orbitsSoFar += skippedCount;
+    task->skippedSoFar += skippedCount;
+    task->batchCount = kept;
 
-    printf("+");
-    for (int i = 0; i < g_n*2 + 1; i++)
-        printf("-");
-    printf("+\n");
+    if (g_prefilterVerify && skippedCount) {
+        int lengths[WATER_BATCH_SIZE];
+        water_lengths(&g_ctx, skippedStates, lengths, skippedCount);
+        for (size_t i = 0; i < skippedCount; i++) {
+            if (lengths[i] > task->skippedMaxLength) {
+                task->skippedMaxLength = lengths[i];
+                task->skippedBestState = skippedStates[i];
+            }
+        }
+    }
 }
 
 // ---------------------------------------------------------------------
-// ThreadTask struct: each worker thread gets a range [start,end)
+// Worker side: evaluating the canonical states of a job
 // ---------------------------------------------------------------------
-typedef struct {
-    uint64_t startState;     // inclusive
-    uint64_t endState;       // exclusive
-    int localMaxLength;
-    uint64_t localBestState;
-} ThreadTask;
+static void flushBatch(ThreadTask* task) {
+    if (g_prefilterRules) {
+        uint64_t start = g_telemetry ? nowNanos() : 0;
+        prefilterBatch(task);
+        if (g_telemetry)
+            task->prefilterNanos += nowNanos() - start;
+    }
+
+    int lengths[WATER_BATCH_SIZE];
+    int kernel = nextKernel(task);
+    int timed = g_telemetry || task->kernelBatches < g_kernelTrialBatches;
+    uint64_t before = timed ? nowNanos() : 0;
+    g_kernels[kernel](&g_ctx, task->batch, lengths, task->batchCount);
+    uint64_t after = timed ? nowNanos() : 0;
+    countKernelBatch(task, kernel, task->batchCount, after - before);
+
+    uint64_t steps = 0;
+    for (size_t i = 0; i < task->batchCount; i++) {
+        steps += (uint64_t)lengths[i];
+        task->histogram[lengths[i]] += task->batchWeight[i];
+        if (task->census)
+            task->census[censusIndex(lengths[i], water_popcount(task->batch[i]))] += task->batchWeight[i];
+        if (g_maximizerPath && lengths[i] >= task->maximizers.length)
+            noteMaximizer(task, task->batch[i], lengths[i], task->batchWeight[i]);
+        if (lengths[i] > task->jobMaxLength) {
+            task->jobMaxLength = lengths[i];
+            task->jobBestState = task->batch[i];
+        }
+    }
+    task->jobOrbits += task->batchCount;
+    task->orbitsSoFar += task->batchCount;
+    task->stepsSoFar += steps;
+    task->batchCount = 0;
+    // Only this thread writes its counters; the progress thread sums them
+    atomic_store_explicit(&task->covered, task->coveredSoFar, memory_order_relaxed);
+    if (g_telemetry) {
+        task->simNanos += after - before;
+        atomic_store_explicit(&task->telOrbits, task->orbitsSoFar, memory_order_relaxed);
+        atomic_store_explicit(&task->telSteps, task->stepsSoFar, memory_order_relaxed);
+        atomic_store_explicit(&task->telSimNanos, task->simNanos, memory_order_relaxed);
+        atomic_store_explicit(&task->telPrefilterNanos, task->prefilterNanos, memory_order_relaxed);
+        atomic_store_explicit(&task->telBusyNanos, after - task->startNanos, memory_order_relaxed);
+        atomic_store_explicit(&task->telSkipped, task->skippedSoFar, memory_order_relaxed);
+        if (task->jobMaxLength > atomic_load_explicit(&task->telMaxLength, memory_order_relaxed))
+            atomic_store_explicit(&task->telMaxLength, task->jobMaxLength, memory_order_relaxed);
+    }
+}
+
+static inline void emitState(ThreadTask* task, uint64_t state, int stabilizer) {
+    task->batchWeight[task->batchCount] = (uint8_t)(8 / stabilizer);
+    task->batch[task->batchCount++] = state;
+    task->coveredSoFar += (uint64_t)(8 / stabilizer);
+    task->jobCovered   += (uint64_t)(8 / stabilizer);
+    if (task->batchCount == WATER_BATCH_SIZE)
+        flushBatch(task);
+}
+
+// Every completion of 'state' over orbits o..end is canonical with a
+// trivial stabilizer: walk them in Gray-code order
+static void emitAll(ThreadTask* task, int o, uint64_t state) {
+    const int* free = g_freeCells[o];
+    uint64_t count = 1ULL << g_freeCellCount[o];
+    emitState(task, state, 1);
+    for (uint64_t i = 1; i < count; i++) {
+        state ^= 1ULL << free[__builtin_ctzll(i)];
+        emitState(task, state, 1);
+    }
+}
+
+static void searchOrbits(ThreadTask* task, int o, uint64_t state, unsigned unresolved) {
+    if (unresolved == 0) {
+        emitAll(task, o, state);
+        return;
+    }
+    if (o == g_orbitCount) {
+        // the symmetries still tied map the state onto itself
+        emitState(task, state, 1 + __builtin_popcount(unresolved));
+        return;
+    }
+    for (unsigned v = 0; v < (1u << g_orbitSize[o]); v++) {
+        unsigned r = unresolved;
+        if (checkBlock(o, v, &r))
+            searchOrbits(task, o + 1, state | g_orbitBlockState[o][v], r);
+    }
+}
+
+static void runJob(ThreadTask* task, uint64_t job) {
+    task->jobMaxLength = 0;
+    task->jobBestState = 0ULL;
+    task->jobOrbits = 0ULL;
+    task->jobCovered = 0ULL;
+
+    searchOrbits(task, g_jobDepth, g_jobs[job].state, g_jobs[job].unresolved);
+    flushBatch(task);
+
+    JobResult* result = &g_jobResults[job];
+    result->thread    = task->id;
+    result->maxLength = task->jobMaxLength;
+    result->bestState = task->jobBestState;
+    result->covered   = task->jobCovered;
+    result->orbits    = task->jobOrbits;
+    atomic_store_explicit(&result->done, 1, memory_order_release);
+
+    task->localOrbits += task->jobOrbits;
+    if (task->jobMaxLength > task->localMaxLength) {
+        task->localMaxLength = task->jobMaxLength;
+        task->localBestState = task->jobBestState;
+    }
+}
 
 // ---------------------------------------------------------------------
 // Worker thread function
 // ---------------------------------------------------------------------
 void* workerThreadFunc(void* arg) {
     ThreadTask* task = (ThreadTask*)arg;
+    task->startNanos = g_telemetry ? nowNanos() : 0;
+
+    uint64_t slot;
+    while (nextJob(task, &slot)) {
+        runJob(task, g_pending[slot]);
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------
+// Checkpoints
+//
+// A checkpoint is a small text file: the job layout, the totals and
+// per-thread bests of every finished job, and the finished jobs as
+// [begin, end) ranges. It is written to "<path>.tmp", synced and renamed
+// over <path>, so a crash leaves either the old or the new checkpoint.
+// ---------------------------------------------------------------------
+static int writeCheckpoint(const char* path) {
+    Totals total = g_resumed;
+    Totals* perThread = (Totals*)calloc((size_t)g_threadCount, sizeof(Totals));
 
-    int localMax = 0;
-    uint64_t localBest = 0ULL;
+    // Snapshot which jobs are done, so the totals and the ranges we write
+    // agree even while workers keep finishing jobs
+    unsigned char* done = (unsigned char*)malloc(g_jobCount + 1);
+    for (uint64_t j = 0; j < g_jobCount; j++)
+        done[j] = (unsigned char)atomic_load_explicit(&g_jobResults[j].done, memory_order_acquire);
 
-    for (uint64_t s = task->startState; s < task->endState; s++) {
-        int length = compute_length(s);
-        if (length > localMax) {
-            localMax  = length;
-            localBest = s;
+    for (uint64_t j = 0; j < g_jobCount; j++) {
+        const JobResult* r = &g_jobResults[j];
+        if (!done[j] || r->thread < 0)
+            continue;
+        total.covered += r->covered;
+        total.orbits  += r->orbits;
+        if (r->maxLength > total.maxLength) {
+            total.maxLength = r->maxLength;
+            total.bestState = r->bestState;
+        }
+        if (r->maxLength > perThread[r->thread].maxLength) {
+            perThread[r->thread].maxLength = r->maxLength;
+            perThread[r->thread].bestState = r->bestState;
         }
-        // Increment the global processed_count by 1
-        atomic_fetch_add(&processed_count, 1ULL);
     }
-    task->localMaxLength = localMax;
-    task->localBestState = localBest;
-    return NULL;
+
+    char tmpPath[4096];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE* f = fopen(tmpPath, "w");
+    if (!f) {
+        free(perThread);
+        free(done);
+        return 0;
+    }
+    fprintf(f, "water-problem-checkpoint 1\n");
+    fprintf(f, "n %d\n", g_n);
+    fprintf(f, "job-depth %d\n", g_jobDepth);
+    fprintf(f, "jobs %llu\n", (unsigned long long)g_jobCount);
+    fprintf(f, "max-length %d\n", total.maxLength);
+    fprintf(f, "best-state %" PRIu64 "\n", total.bestState);
+    fprintf(f, "covered %" PRIu64 "\n", total.covered);
+    fprintf(f, "orbits %" PRIu64 "\n", total.orbits);
+    for (int i = 0; i < g_threadCount; i++) {
+        fprintf(f, "thread %d %d %" PRIu64 "\n", i, perThread[i].maxLength, perThread[i].bestState);
+    }
+
+    // Finished jobs as ranges: count them first, then list them
+    uint64_t rangeCount = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1)
+            fprintf(f, "done-ranges %llu\n", (unsigned long long)rangeCount);
+        rangeCount = 0;
+        for (uint64_t j = 0; j < g_jobCount; ) {
+            if (!done[j]) {
+                j++;
+                continue;
+            }
+            uint64_t begin = j;
+            while (j < g_jobCount && done[j])
+                j++;
+            if (pass == 1)
+                fprintf(f, "%llu %llu\n", (unsigned long long)begin, (unsigned long long)j);
+            rangeCount++;
+        }
+    }
+    free(perThread);
+    free(done);
+
+    int ok = (fflush(f) == 0);
+#ifndef _WIN32
+    ok = ok && (fsync(fileno(f)) == 0);
+#endif
+    ok = (fclose(f) == 0) && ok;
+    return ok && rename(tmpPath, path) == 0;
+}
+
+// Read a checkpoint into g_resumed, the job depth and the list of finished
+// job ranges; the ranges are applied once the jobs have been rebuilt.
+typedef struct {
+    int n;
+    int jobDepth;
+    uint64_t jobCount;
+    uint64_t rangeCount;
+    uint64_t* ranges;        // begin,end pairs
+} Checkpoint;
+
+static int readCheckpoint(const char* path, Checkpoint* cp) {
+    FILE* f = fopen(path, "r");
+    if (!f)
+        return 0;
+
+    int version = 0;
+    unsigned long long jobs = 0, ranges = 0;
+    int ok = fscanf(f, " water-problem-checkpoint %d", &version) == 1 && version == 1
+          && fscanf(f, " n %d", &cp->n) == 1
+          && fscanf(f, " job-depth %d", &cp->jobDepth) == 1
+          && fscanf(f, " jobs %llu", &jobs) == 1
+          && fscanf(f, " max-length %d", &g_resumed.maxLength) == 1
+          && fscanf(f, " best-state %" SCNu64, &g_resumed.bestState) == 1
+          && fscanf(f, " covered %" SCNu64, &g_resumed.covered) == 1
+          && fscanf(f, " orbits %" SCNu64, &g_resumed.orbits) == 1
+          && cp->n >= 1 && cp->n <= 8
+          && cp->jobDepth >= 0 && cp->jobDepth <= MAX_ORBITS;
+
+    // per-thread lines are informational; the totals already include them
+    int id, length;
+    uint64_t best;
+    while (ok && fscanf(f, " thread %d %d %" SCNu64, &id, &length, &best) == 3)
+        ;
+    ok = ok && fscanf(f, " done-ranges %llu", &ranges) == 1;
+
+    cp->jobCount = jobs;
+    cp->rangeCount = ranges;
+    cp->ranges = ok ? (uint64_t*)malloc(sizeof(uint64_t) * 2 * (ranges + 1)) : NULL;
+    for (uint64_t r = 0; ok && r < ranges; r++) {
+        unsigned long long b, e;
+        ok = fscanf(f, " %llu %llu", &b, &e) == 2 && b <= e && e <= jobs;
+        cp->ranges[2 * r]     = b;
+        cp->ranges[2 * r + 1] = e;
+    }
+    fclose(f);
+    return ok;
+}
+
+// ---------------------------------------------------------------------
+// Telemetry
+//
+// With --telemetry TARGET the progress thread writes one JSON object per
+// line to a file (appended to) or, for TARGET = unix:PATH, to a listening
+// stream socket. The records are
+//   start     n, threads, kernel and the size of the run
+//   progress  every --telemetry-interval seconds: totals, ETA, average
+//             steps per evaluated state, orbits the prefilter skipped
+//             (counted in "orbits" too), time split between simulation,
+//             prefilter and the canonical generation, and the same per
+//             thread
+//   best      whenever the longest length seen so far grows
+//   done      totals of a finished run (one per shard in shard mode)
+// Times are seconds since the process started. The workers never format
+// or write anything: once per batch they read the clock twice and copy a
+// few local counters into their own cache line, and the progress thread
+// reads those with relaxed loads.
+// ---------------------------------------------------------------------
+static int g_telemetryFd = -1;
+static int g_telemetrySocket = 0;         // g_telemetryFd is a socket, not a file
+static double g_telemetryInterval = 2.0;
+static uint64_t g_telemetryStart;         // nowNanos() at startup
+static int g_telemetryBest = 0;           // last length sent in a "best" record
+
+typedef struct {
+    char* data;
+    size_t len, cap;
+} TextBuf;
+
+static void textf(TextBuf* b, const char* fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int need = vsnprintf(b->data + b->len, b->cap - b->len, fmt, ap);
+        va_end(ap);
+        if (need >= 0 && (size_t)need < b->cap - b->len) {
+            b->len += (size_t)need;
+            return;
+        }
+        b->cap = 2 * b->cap + (size_t)need + 1;
+        b->data = (char*)realloc(b->data, b->cap);
+    }
+}
+
+static double telemetryTime(void) {
+    return 1e-9 * (double)(nowNanos() - g_telemetryStart);
+}
+
+#ifndef _WIN32
+static int openTelemetry(const char* target) {
+    if (strncmp(target, "unix:", 5) == 0) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(target + 5) >= sizeof(addr.sun_path))
+            return -1;
+        strcpy(addr.sun_path, target + 5);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+#ifndef MSG_NOSIGNAL
+        // no per-call flag here: a reader that went away must not kill us
+        signal(SIGPIPE, SIG_IGN);
+#endif
+        g_telemetrySocket = 1;
+        return fd;
+    }
+    g_telemetrySocket = 0;
+    return open(target, O_WRONLY | O_CREAT | O_APPEND, 0666);
+}
+
+// Send one record; a reader that went away turns telemetry off
+static void sendTelemetry(TextBuf* b) {
+    if (g_telemetryFd < 0)
+        return;
+    textf(b, "\n");
+    size_t done = 0;
+    while (done < b->len) {
+        ssize_t w;
+#ifdef MSG_NOSIGNAL
+        if (g_telemetrySocket)
+            w = send(g_telemetryFd, b->data + done, b->len - done, MSG_NOSIGNAL);
+        else
+#endif
+            w = write(g_telemetryFd, b->data + done, b->len - done);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0) {
+            printf("Warning: telemetry stopped (%s)\n", strerror(errno));
+            close(g_telemetryFd);
+            g_telemetryFd = -1;
+            break;
+        }
+        done += (size_t)w;
+    }
+    b->len = 0;
+}
+#else
+static void sendTelemetry(TextBuf* b) {
+    b->len = 0;
+}
+#endif
+
+// Snapshot of one thread's counters
+typedef struct {
+    uint64_t covered, orbits, skipped, steps, simNanos, prefilterNanos, busyNanos;
+    int maxLength;
+} ThreadSample;
+
+static void sampleThread(int i, ThreadSample* t) {
+    ThreadTask* task = &g_tasks[i];
+    t->covered   = atomic_load_explicit(&task->covered, memory_order_relaxed);
+    t->orbits    = atomic_load_explicit(&task->telOrbits, memory_order_relaxed);
+    t->steps     = atomic_load_explicit(&task->telSteps, memory_order_relaxed);
+    t->skipped   = atomic_load_explicit(&task->telSkipped, memory_order_relaxed);
+    t->simNanos  = atomic_load_explicit(&task->telSimNanos, memory_order_relaxed);
+    t->prefilterNanos = atomic_load_explicit(&task->telPrefilterNanos, memory_order_relaxed);
+    t->busyNanos = atomic_load_explicit(&task->telBusyNanos, memory_order_relaxed);
+    t->maxLength = atomic_load_explicit(&task->telMaxLength, memory_order_relaxed);
+    if (t->busyNanos < t->simNanos + t->prefilterNanos)
+        t->busyNanos = t->simNanos + t->prefilterNanos;
+}
+
+// Average length of the orbits actually evaluated (skipped ones have none)
+static double averageSteps(const ThreadSample* t) {
+    uint64_t evaluated = t->orbits - t->skipped;
+    return evaluated ? (double)t->steps / (double)evaluated : 0.0;
+}
+
+// Busy time that was neither simulation nor prefilter
+static double canonicalSeconds(const ThreadSample* t) {
+    return 1e-9 * (double)(t->busyNanos - t->simNanos - t->prefilterNanos);
+}
+
+// A "best" record if some thread has gone past the last one sent
+static void telemetryBest(TextBuf* b) {
+    int best = g_telemetryBest, thread = -1;
+    for (int i = 0; i < g_threadCount; i++) {
+        int l = atomic_load_explicit(&g_tasks[i].telMaxLength, memory_order_relaxed);
+        if (l > best) {
+            best = l;
+            thread = i;
+        }
+    }
+    if (thread < 0)
+        return;
+    g_telemetryBest = best;
+    textf(b, "{\"event\":\"best\",\"t\":%.3f,\"length\":%d,\"thread\":%d}", telemetryTime(), best, thread);
+    sendTelemetry(b);
+}
+
+// 'last' holds each thread's covered count at the previous record
+static void telemetryProgress(TextBuf* b, double totalStates, double pendingWeight,
+                              double elapsed, double sinceLast, uint64_t* last) {
+    ThreadSample sum;
+    memset(&sum, 0, sizeof(sum));
+    ThreadSample* t = (ThreadSample*)malloc(sizeof(ThreadSample) * (size_t)g_threadCount);
+    for (int i = 0; i < g_threadCount; i++) {
+        sampleThread(i, &t[i]);
+        sum.covered   += t[i].covered;
+        sum.orbits    += t[i].orbits;
+        sum.skipped   += t[i].skipped;
+        sum.steps     += t[i].steps;
+        sum.simNanos  += t[i].simNanos;
+        sum.prefilterNanos += t[i].prefilterNanos;
+        sum.busyNanos += t[i].busyNanos;
+        if (t[i].maxLength > sum.maxLength)
+            sum.maxLength = t[i].maxLength;
+    }
+
+    // The ETA goes by representatives, the unit the jobs are weighed in
+    double rate = elapsed > 0.0 ? (double)sum.covered / elapsed : 0.0;
+    double orbitRate = elapsed > 0.0 ? (double)sum.orbits / elapsed : 0.0;
+    double left = pendingWeight - (double)sum.orbits;
+    double eta = (orbitRate > 0.0) ? (left > 0.0 ? left : 0.0) / orbitRate : -1.0;
+
+    textf(b, "{\"event\":\"progress\",\"t\":%.3f,\"covered\":%llu,\"total_states\":%.0f,"
+             "\"percent\":%.4f,\"states_per_s\":%.4g,\"orbits\":%llu,\"eta_s\":%.1f,"
+             "\"skipped\":%llu,\"avg_steps\":%.4f,\"max_length\":%d,\"sim_s\":%.3f,"
+             "\"prefilter_s\":%.3f,\"canon_s\":%.3f,\"threads\":[",
+          telemetryTime(), (unsigned long long)(g_resumed.covered + sum.covered), totalStates,
+          100.0 * (double)(g_resumed.covered + sum.covered) / totalStates, rate,
+          (unsigned long long)sum.orbits, eta, (unsigned long long)sum.skipped,
+          averageSteps(&sum), sum.maxLength, 1e-9 * (double)sum.simNanos,
+          1e-9 * (double)sum.prefilterNanos, canonicalSeconds(&sum));
+    for (int i = 0; i < g_threadCount; i++) {
+        textf(b, "%s{\"id\":%d,\"covered\":%llu,\"states_per_s\":%.4g,\"orbits\":%llu,"
+                 "\"skipped\":%llu,\"avg_steps\":%.4f,\"max_length\":%d,\"sim_s\":%.3f,"
+                 "\"prefilter_s\":%.3f,\"canon_s\":%.3f}",
+              i ? "," : "", i, (unsigned long long)t[i].covered,
+              sinceLast > 0.0 ? (double)(t[i].covered - last[i]) / sinceLast : 0.0,
+              (unsigned long long)t[i].orbits, (unsigned long long)t[i].skipped,
+              averageSteps(&t[i]), t[i].maxLength, 1e-9 * (double)t[i].simNanos,
+              1e-9 * (double)t[i].prefilterNanos, canonicalSeconds(&t[i]));
+        last[i] = t[i].covered;
+    }
+    textf(b, "]}");
+    sendTelemetry(b);
+    free(t);
 }
 
 // ---------------------------------------------------------------------
 // Progress thread function
-// Waits and periodically prints how many states have been processed.
+// Waits and periodically prints how many states have been covered, and
+// writes a checkpoint every checkpointInterval seconds if asked to.
 // ---------------------------------------------------------------------
 typedef struct {
-    uint64_t totalStates;
-    int doneFlag; // We'll set this once all workers are joined
+    double totalStates;     // 2^(n*n) does not fit in 64 bits for n = 8
+    double pendingWeight;   // representatives in the jobs of this run
+    _Atomic int doneFlag;   // We'll set this once all workers are joined
+    const char* checkpointPath;
+    int checkpointInterval;
 } ProgressTask;
 
+static void sleepMillis(int ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static double secondsSince(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + 1e-9 * (double)(now.tv_nsec - start->tv_nsec);
+}
+
 void* progressThreadFunc(void* arg) {
     ProgressTask* pt = (ProgressTask*)arg;
-    uint64_t total = pt->totalStates;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double lastCheckpoint = 0.0;
+    double lastTelemetry = 0.0;
+    TextBuf text = { NULL, 0, 0 };
+    uint64_t* lastCovered = (uint64_t*)calloc((size_t)g_threadCount, sizeof(uint64_t));
 
-    while (1) {
-        // If the doneFlag is set or we've reached totalStates, break
-        uint64_t doneSoFar = atomic_load(&processed_count);
-        if (pt->doneFlag || doneSoFar >= total) {
-            break;
+    int ticks = 0;
+    while (!atomic_load(&pt->doneFlag)) {
+        // Poll often so we exit promptly, but only print every 2 seconds
+        sleepMillis(100);
+        ++ticks;
+        if (g_telemetryFd >= 0) {
+            telemetryBest(&text);
+            double elapsed = secondsSince(&start);
+            if (elapsed - lastTelemetry >= g_telemetryInterval) {
+                telemetryProgress(&text, pt->totalStates, pt->pendingWeight,
+                                  elapsed, elapsed - lastTelemetry, lastCovered);
+                lastTelemetry = elapsed;
+            }
+        }
+        if (ticks % 20 != 0)
+            continue;
+
+        uint64_t doneSoFar = 0;
+        for (int i = 0; i < g_threadCount; i++)
+            doneSoFar += atomic_load_explicit(&g_tasks[i].covered, memory_order_relaxed);
+
+        double elapsed = secondsSince(&start);
+        double percent = 100.0 * (double)(g_resumed.covered + doneSoFar) / pt->totalStates;
+        printf("Progress: %llu / %.0f (%.2f%%), %.3g states/s\n",
+               (unsigned long long)(g_resumed.covered + doneSoFar),
+               pt->totalStates,
+               percent,
+               elapsed > 0.0 ? (double)doneSoFar / elapsed : 0.0);
+
+        if (pt->checkpointPath && elapsed - lastCheckpoint >= pt->checkpointInterval) {
+            if (!writeCheckpoint(pt->checkpointPath))
+                printf("Warning: could not write checkpoint %s\n", pt->checkpointPath);
+            lastCheckpoint = elapsed;
         }
+    }
 
-        double percent = 100.0 * (double)doneSoFar / (double)total;
-        printf("Progress: %llu / %llu (%.2f%%)\n",
-               (unsigned long long)doneSoFar,
-               (unsigned long long)total,
-               percent);
+    // The workers are joined: send the final counts unless the last
+    // record already had them
+    if (g_telemetryFd >= 0) {
+        telemetryBest(&text);
+        int changed = 0;
+        for (int i = 0; i < g_threadCount; i++)
+            changed |= atomic_load_explicit(&g_tasks[i].covered, memory_order_relaxed) != lastCovered[i];
+        double elapsed = secondsSince(&start);
+        if (changed)
+            telemetryProgress(&text, pt->totalStates, pt->pendingWeight,
+                              elapsed, elapsed - lastTelemetry, lastCovered);
+    }
+    free(lastCovered);
+    free(text.data);
+    return NULL;
+}
 
-        // Sleep a bit so we don't spam output
+static int defaultThreadCount(void) {
 #ifdef _WIN32
-        // On Windows you might use Sleep(2000) from <windows.h> in milliseconds
-        Sleep(2000);
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
 #else
-        // POSIX sleep in seconds
-        sleep(2);
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
 #endif
-    }
-    return NULL;
 }
 
 // ---------------------------------------------------------------------
-// main()
+// Run every job in g_pending and add the results to *total, histogram
+// and, unless it is NULL, census
 // ---------------------------------------------------------------------
-int main(void) {
-    printf("Enter grid size (1 to 8): ");
-    if (scanf("%d", &g_n) != 1 || g_n < 1 || g_n > 8) {
-        printf("Invalid input.\n");
-        return 1;
-    }
-
-    // Choose how many threads to launch
-    int threadCount = 4; // or read from user
-
-    // Build neighbor masks
-    buildNeighborMasks();
+static void runPending(int threadCount, const char* checkpointPath, int checkpointInterval,
+                       Totals* total, uint64_t* histogram, uint64_t* census) {
+    // Create worker tasks. Initial ranges hold about the same number of
+    // representatives each; stealing evens out the rest.
+    double totalWeight = 0.0;
+    for (uint64_t p = 0; p < g_pendingCount; p++)
+        totalWeight += jobWeight(&g_jobs[g_pending[p]]);
 
-    // Number of total states
-    uint64_t totalStates = (1ULL << (g_n * g_n));
+    g_threadCount = threadCount;
+    g_tasks = (ThreadTask*)aligned_alloc(_Alignof(ThreadTask), sizeof(ThreadTask)*threadCount);
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t)*threadCount);
+    uint64_t begin = 0;
+    double weightSoFar = 0.0;
+    for (int i = 0; i < threadCount; i++) {
+        uint64_t end = begin;
+        double target = totalWeight * (double)(i + 1) / (double)threadCount;
+        while (end < g_pendingCount && (weightSoFar < target || i == threadCount - 1)) {
+            weightSoFar += jobWeight(&g_jobs[g_pending[end]]);
+            end++;
+        }
+        atomic_init(&g_tasks[i].range, packRange(begin, end));
+        atomic_init(&g_tasks[i].covered, 0ULL);
+        atomic_init(&g_tasks[i].telOrbits, 0ULL);
+        atomic_init(&g_tasks[i].telSteps, 0ULL);
+        atomic_init(&g_tasks[i].telSimNanos, 0ULL);
+        atomic_init(&g_tasks[i].telPrefilterNanos, 0ULL);
+        atomic_init(&g_tasks[i].telSkipped, 0ULL);
+        atomic_init(&g_tasks[i].telBusyNanos, 0ULL);
+        atomic_init(&g_tasks[i].telMaxLength, 0);
+        g_tasks[i].id = i;
+        g_tasks[i].localMaxLength = 0;
+        g_tasks[i].localBestState = 0ULL;
+        g_tasks[i].localOrbits = 0ULL;
+        memset(g_tasks[i].histogram, 0, sizeof(g_tasks[i].histogram));
+        g_tasks[i].census = census ? (uint64_t*)calloc(CENSUS_SIZE, sizeof(uint64_t)) : NULL;
+        memset(g_tasks[i].skipped, 0, sizeof(g_tasks[i].skipped));
+        g_tasks[i].skippedMaxLength = 0;
+        g_tasks[i].skippedBestState = 0ULL;
+        memset(&g_tasks[i].maximizers, 0, sizeof(Maximizers));
+        if (g_maximizerPath)
+            g_tasks[i].maximizers.buffer = (uint64_t*)malloc(sizeof(uint64_t) * MAXIMIZER_BUFFER);
+        g_tasks[i].batchCount = 0;
+        g_tasks[i].coveredSoFar = 0ULL;
+        g_tasks[i].orbitsSoFar = 0ULL;
+        g_tasks[i].skippedSoFar = 0ULL;
+        g_tasks[i].stepsSoFar = 0ULL;
+        g_tasks[i].simNanos = 0ULL;
+        g_tasks[i].prefilterNanos = 0ULL;
+        g_tasks[i].kernel = 0;
+        g_tasks[i].kernelBatches = 0ULL;
+        memset(g_tasks[i].kernelNanos, 0, sizeof(g_tasks[i].kernelNanos));
+        memset(g_tasks[i].kernelStates, 0, sizeof(g_tasks[i].kernelStates));
+        begin = end;
+    }
 
     // Create the progress thread
     ProgressTask ptask;
-    ptask.totalStates = totalStates;
-    ptask.doneFlag    = 0;
+    ptask.totalStates = 1.0;
+    for (int c = 0; c < g_n * g_n; c++)
+        ptask.totalStates *= 2.0;
+    ptask.pendingWeight = totalWeight;
+    atomic_init(&ptask.doneFlag, 0);
+    ptask.checkpointPath = checkpointPath;
+    ptask.checkpointInterval = checkpointInterval;
     pthread_t progressThread;
     pthread_create(&progressThread, NULL, progressThreadFunc, &ptask);
 
-    // Create worker threads
-    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t)*threadCount);
-    ThreadTask* tasks  = (ThreadTask*)malloc(sizeof(ThreadTask)*threadCount);
-
-    // Divide the state space among threads
-    uint64_t chunkSize = totalStates / threadCount;
-    uint64_t remainder = totalStates % threadCount;
-
-    uint64_t start = 0ULL;
     for (int i = 0; i < threadCount; i++) {
-        uint64_t end = start + chunkSize;
-        if (remainder > 0) {
-            end++;
-            remainder--;
-        }
-        tasks[i].startState = start;
-        tasks[i].endState   = end;
-        tasks[i].localMaxLength = 0;
-        tasks[i].localBestState = 0ULL;
-        pthread_create(&threads[i], NULL, workerThreadFunc, &tasks[i]);
-        start = end;
+        pthread_create(&threads[i], NULL, workerThreadFunc, &g_tasks[i]);
     }
 
     // Wait for all workers to finish
-    int globalMaxLength = 0;
-    uint64_t globalBestState = 0ULL;
-
+    int kernelPicks[3] = { 0, 0, 0 };
     for (int i = 0; i < threadCount; i++) {
         pthread_join(threads[i], NULL);
-        if (tasks[i].localMaxLength > globalMaxLength) {
-            globalMaxLength = tasks[i].localMaxLength;
-            globalBestState = tasks[i].localBestState;
+        kernelPicks[g_tasks[i].kernel]++;
+        total->orbits  += g_tasks[i].localOrbits;
+        total->covered += g_tasks[i].coveredSoFar;
+        if (g_tasks[i].localMaxLength > total->maxLength) {
+            total->maxLength = g_tasks[i].localMaxLength;
+            total->bestState = g_tasks[i].localBestState;
+        }
+        for (int l = 0; l <= MAX_LENGTH; l++)
+            histogram[l] += g_tasks[i].histogram[l];
+        if (census) {
+            for (size_t k = 0; k < CENSUS_SIZE; k++)
+                census[k] += g_tasks[i].census[k];
+            free(g_tasks[i].census);
+        }
+        for (int r = 0; r < PREFILTER_RULES; r++)
+            g_prefilterSkipped[r] += g_tasks[i].skipped[r];
+        if (g_tasks[i].skippedMaxLength > g_prefilterSkippedMax) {
+            g_prefilterSkippedMax = g_tasks[i].skippedMaxLength;
+            g_prefilterSkippedState = g_tasks[i].skippedBestState;
         }
     }
 
     // Tell the progress thread we're done
-    ptask.doneFlag = 1;
+    atomic_store(&ptask.doneFlag, 1);
 
     // Wait for progress thread to exit
     pthread_join(progressThread, NULL);
 
-    // Print results
-    printf("Max length = %d\n", globalMaxLength);
-    printf("Best state = %" PRIu64 "\n", globalBestState);
-    printGrid(globalBestState);
+    if (g_kernelCount > 1) {
+        const char* separator = ":";
+        printf("Batch kernel at the end");
+        for (int k = 0; k < g_kernelCount; k++) {
+            if (!kernelPicks[k])
+                continue;
+            printf("%s %s on %d thread%s", separator, water_isaName(g_kernelIsa[k]), kernelPicks[k],
+                   kernelPicks[k] > 1 ? "s" : "");
+            separator = ",";
+        }
+        printf("\n");
+    }
+
+    if (g_telemetryFd >= 0) {
+        TextBuf text = { NULL, 0, 0 };
+        textf(&text, "{\"event\":\"done\",\"t\":%.3f,\"covered\":%llu,\"orbits\":%llu,"
+                     "\"max_length\":%d,\"best_state\":%" PRIu64 "}",
+              telemetryTime(), (unsigned long long)total->covered,
+              (unsigned long long)total->orbits, total->maxLength, total->bestState);
+        sendTelemetry(&text);
+        free(text.data);
+    }
+
+    // The final checkpoint records the finished run
+    if (checkpointPath && !writeCheckpoint(checkpointPath))
+        printf("Warning: could not write checkpoint %s\n", checkpointPath);
+
+    if (g_maximizerPath) {
+        uint64_t orbits, raw;
+        if (writeMaximizers(g_maximizerPath, &orbits, &raw))
+            printf("Maximizers: %llu up to symmetry, %llu in total (written to %s)\n",
+                   (unsigned long long)orbits, (unsigned long long)raw, g_maximizerPath);
+        else
+            printf("Warning: could not write maximizers to %s\n", g_maximizerPath);
+        for (int i = 0; i < threadCount; i++) {
+            resetMaximizers(&g_tasks[i].maximizers, 0);
+            free(g_tasks[i].maximizers.buffer);
+        }
+    }
 
     free(threads);
-    free(tasks);
+    free(g_tasks);
+    g_tasks = NULL;
+}
+
+// ---------------------------------------------------------------------
+// Census output
+//
+// --census FILE keeps, next to the length histogram, the number of states
+// for every (length, number of initial cells) pair. Both are orbit
+// weighted: a canonical state counts for the 8 / stabilizer states of its
+// orbit, all of which have its length and cell count. The file has two
+// comment lines and then one "length cells states" line per non-zero entry.
+// ---------------------------------------------------------------------
+static int writeCensus(const char* path, const uint64_t* census) {
+    FILE* f = fopen(path, "w");
+    if (!f)
+        return 0;
+    fprintf(f, "# water-problem census, n = %d\n", g_n);
+    fprintf(f, "# length cells states\n");
+    for (int l = 0; l <= MAX_LENGTH; l++) {
+        for (int c = 0; c < CENSUS_CELLS; c++) {
+            if (census[censusIndex(l, c)])
+                fprintf(f, "%d %d %" PRIu64 "\n", l, c, census[censusIndex(l, c)]);
+        }
+    }
+    return fclose(f) == 0;
+}
+
+static void printHistogram(const uint64_t* histogram) {
+    printf("Length histogram (states):\n");
+    if (histogram[0])
+        printf("skipped by --prefilter %" PRIu64 "\n", histogram[0]);
+    for (int l = 1; l <= MAX_LENGTH; l++) {
+        if (histogram[l])
+            printf("%3d %" PRIu64 "\n", l, histogram[l]);
+    }
+}
+
+// ---------------------------------------------------------------------
+// Sharded runs
+//
+// A shard directory splits the jobs between any number of processes, on
+// one machine or on several that share the directory. Its 'manifest' fixes
+// n, the job layout and the number of shards; shard s is the jobs
+// [s * jobs / shards, (s + 1) * jobs / shards).
+//
+// A process claims a shard by taking an flock on 'shard-<s>.lock' and
+// finishes it by renaming 'shard-<s>.result' into place, so a result file
+// is always complete. A process that dies loses its lock with it, and the
+// shard goes to the next process that looks. --merge combines the result
+// files into the totals of a whole run.
+//
+// Across machines this relies on the shared file system honouring flock
+// (NFSv4 does, through byte-range locks).
+// ---------------------------------------------------------------------
+typedef struct {
+    int n;
+    int jobDepth;
+    uint64_t jobCount;
+    int shardCount;
+} Manifest;
+
+typedef struct {
+    Totals total;
+    uint64_t histogram[MAX_LENGTH + 1];
+    int hasCensus;                    // the shard ran with --census
+    uint64_t census[CENSUS_SIZE];
+} ShardResult;
+
+static inline uint64_t shardBegin(const Manifest* m, int s) {
+    return m->jobCount * (uint64_t)s / (uint64_t)m->shardCount;
+}
+
+static int readManifest(const char* dir, Manifest* m) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/manifest", dir);
+    FILE* f = fopen(path, "r");
+    if (!f)
+        return 0;
+    int version = 0;
+    unsigned long long jobs = 0;
+    int ok = fscanf(f, " water-problem-manifest %d", &version) == 1 && version == 1
+          && fscanf(f, " n %d", &m->n) == 1
+          && fscanf(f, " job-depth %d", &m->jobDepth) == 1
+          && fscanf(f, " jobs %llu", &jobs) == 1
+          && fscanf(f, " shards %d", &m->shardCount) == 1
+          && m->n >= 1 && m->n <= 8 && m->shardCount >= 1
+          && m->jobDepth >= 0 && m->jobDepth <= MAX_ORBITS;
+    m->jobCount = jobs;
+    fclose(f);
+    return ok;
+}
+
+#ifndef _WIN32
+static int writeResultFile(const char* tmpPath, const char* path, const char* text) {
+    FILE* f = fopen(tmpPath, "w");
+    if (!f)
+        return 0;
+    int ok = fputs(text, f) >= 0 && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = (fclose(f) == 0) && ok;
+    return ok && rename(tmpPath, path) == 0;
+}
+
+// Create the manifest unless another process got there first; either way
+// *m is then whatever the directory holds
+static int createManifest(const char* dir, Manifest* m) {
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST)
+        return 0;
+
+    char path[4096], tmpPath[4096];
+    snprintf(path, sizeof(path), "%s/manifest", dir);
+    snprintf(tmpPath, sizeof(tmpPath), "%s/manifest.%ld.tmp", dir, (long)getpid());
+    FILE* f = fopen(tmpPath, "w");
+    if (!f)
+        return 0;
+    fprintf(f, "water-problem-manifest 1\n");
+    fprintf(f, "n %d\n", m->n);
+    fprintf(f, "job-depth %d\n", m->jobDepth);
+    fprintf(f, "jobs %llu\n", (unsigned long long)m->jobCount);
+    fprintf(f, "shards %d\n", m->shardCount);
+    int ok = (fflush(f) == 0) && (fsync(fileno(f)) == 0);
+    ok = (fclose(f) == 0) && ok;
+
+    // link() fails if the manifest exists, so only one process creates it
+    if (ok && link(tmpPath, path) != 0 && errno != EEXIST)
+        ok = 0;
+    unlink(tmpPath);
+    return ok && readManifest(dir, m);
+}
+
+// A shard run with --census appends a "census K" section of K
+// "length cells states" lines
+static int writeShardResult(const char* dir, const Manifest* m, int s, const ShardResult* r) {
+    TextBuf text = { NULL, 0, 0 };
+    textf(&text, "water-problem-shard 1\n"
+                 "n %d\njob-depth %d\njobs %llu\nshard %d %llu %llu\n"
+                 "max-length %d\nbest-state %" PRIu64 "\n"
+                 "covered %" PRIu64 "\norbits %" PRIu64 "\n",
+          m->n, m->jobDepth, (unsigned long long)m->jobCount, s,
+          (unsigned long long)shardBegin(m, s),
+          (unsigned long long)shardBegin(m, s + 1),
+          r->total.maxLength, r->total.bestState,
+          r->total.covered, r->total.orbits);
+    int lengths = 0;
+    for (int l = 0; l <= MAX_LENGTH; l++)
+        lengths += (r->histogram[l] != 0);
+    textf(&text, "histogram %d\n", lengths);
+    for (int l = 0; l <= MAX_LENGTH; l++) {
+        if (r->histogram[l])
+            textf(&text, "%d %" PRIu64 "\n", l, r->histogram[l]);
+    }
+    if (r->hasCensus) {
+        int entries = 0;
+        for (size_t k = 0; k < CENSUS_SIZE; k++)
+            entries += (r->census[k] != 0);
+        textf(&text, "census %d\n", entries);
+        for (int l = 0; l <= MAX_LENGTH; l++) {
+            for (int c = 0; c < CENSUS_CELLS; c++) {
+                if (r->census[censusIndex(l, c)])
+                    textf(&text, "%d %d %" PRIu64 "\n", l, c, r->census[censusIndex(l, c)]);
+            }
+        }
+    }
+
+    char path[4096], tmpPath[4096];
+    snprintf(path, sizeof(path), "%s/shard-%d.result", dir, s);
+    snprintf(tmpPath, sizeof(tmpPath), "%s/shard-%d.result.%ld.tmp", dir, s, (long)getpid());
+    int ok = writeResultFile(tmpPath, path, text.data);
+    free(text.data);
+    return ok;
+}
+
+static int shardFinished(const char* dir, int s) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/shard-%d.result", dir, s);
+    return access(path, F_OK) == 0;
+}
+
+// Work through the shards nobody has finished or claimed
+static int runShards(const char* dir, const Manifest* m, int threadCount, int census) {
+    int ran = 0;
+    for (int s = 0; s < m->shardCount; s++) {
+        if (shardFinished(dir, s))
+            continue;
+
+        char lockPath[4096];
+        snprintf(lockPath, sizeof(lockPath), "%s/shard-%d.lock", dir, s);
+        int fd = open(lockPath, O_RDWR | O_CREAT, 0666);
+        if (fd < 0) {
+            printf("Could not open %s\n", lockPath);
+            return 1;
+        }
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            close(fd);              // another process is on it
+            continue;
+        }
+        // It may have been finished between the check and the lock
+        if (shardFinished(dir, s)) {
+            close(fd);
+            continue;
+        }
+
+        g_pendingCount = 0;
+        for (uint64_t j = shardBegin(m, s); j < shardBegin(m, s + 1); j++)
+            g_pending[g_pendingCount++] = j;
+        printf("Shard %d / %d: jobs %llu..%llu\n", s, m->shardCount,
+               (unsigned long long)shardBegin(m, s),
+               (unsigned long long)shardBegin(m, s + 1));
+
+        ShardResult r;
+        memset(&r, 0, sizeof(r));
+        r.hasCensus = census;
+        runPending(threadCount, NULL, 0, &r.total, r.histogram, census ? r.census : NULL);
+        if (!writeShardResult(dir, m, s, &r)) {
+            printf("Could not write the result of shard %d\n", s);
+            close(fd);
+            return 1;
+        }
+        close(fd);                  // releases the lock
+        ran++;
+    }
+
+    int finished = 0;
+    for (int s = 0; s < m->shardCount; s++)
+        finished += shardFinished(dir, s);
+    printf("Ran %d shards; %d of %d are finished%s\n", ran, finished, m->shardCount,
+           finished == m->shardCount ? ", ready for --merge" : "");
+    return 0;
+}
+#endif
+
+static int readShardResult(const char* dir, const Manifest* m, int s, ShardResult* r) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/shard-%d.result", dir, s);
+    FILE* f = fopen(path, "r");
+    if (!f)
+        return 0;
+
+    int version = 0, n = 0, depth = 0, shard = -1, lengths = 0;
+    unsigned long long jobs = 0, begin = 0, end = 0;
+    memset(r, 0, sizeof(*r));
+    int ok = fscanf(f, " water-problem-shard %d", &version) == 1 && version == 1
+          && fscanf(f, " n %d", &n) == 1
+          && fscanf(f, " job-depth %d", &depth) == 1
+          && fscanf(f, " jobs %llu", &jobs) == 1
+          && fscanf(f, " shard %d %llu %llu", &shard, &begin, &end) == 3
+          && fscanf(f, " max-length %d", &r->total.maxLength) == 1
+          && fscanf(f, " best-state %" SCNu64, &r->total.bestState) == 1
+          && fscanf(f, " covered %" SCNu64, &r->total.covered) == 1
+          && fscanf(f, " orbits %" SCNu64, &r->total.orbits) == 1
+          && fscanf(f, " histogram %d", &lengths) == 1;
+    ok = ok && n == m->n && depth == m->jobDepth && jobs == m->jobCount && shard == s
+            && begin == shardBegin(m, s) && end == shardBegin(m, s + 1);
+    for (int i = 0; ok && i < lengths; i++) {
+        int l;
+        uint64_t count;
+        ok = fscanf(f, " %d %" SCNu64, &l, &count) == 2 && l >= 0 && l <= MAX_LENGTH;
+        if (ok)
+            r->histogram[l] = count;
+    }
+    int entries = 0;
+    if (ok && fscanf(f, " census %d", &entries) == 1) {
+        r->hasCensus = 1;
+        for (int i = 0; ok && i < entries; i++) {
+            int l, c;
+            uint64_t count;
+            ok = fscanf(f, " %d %d %" SCNu64, &l, &c, &count) == 3
+              && l >= 0 && l <= MAX_LENGTH && c >= 0 && c < CENSUS_CELLS;
+            if (ok)
+                r->census[censusIndex(l, c)] = count;
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+// Combine the shard results of a directory into the totals of the run,
+// and into a census file if censusPath is given
+static int mergeShards(const char* dir, const char* censusPath) {
+    Manifest m;
+    if (!readManifest(dir, &m)) {
+        printf("Could not read %s/manifest\n", dir);
+        return 1;
+    }
+    g_n = m.n;
+    if (water_init(&g_ctx, g_n, 0) != 0) {
+        printf("%s/manifest has n = %d, outside 1..%d\n", dir, g_n, WATER_MAX_N);
+        return 1;
+    }
+
+    Totals total = { 0, 0ULL, 0ULL, 0ULL };
+    uint64_t histogram[MAX_LENGTH + 1] = { 0 };
+    uint64_t* census = (uint64_t*)calloc(CENSUS_SIZE, sizeof(uint64_t));
+    uint64_t* best = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)m.shardCount);
+    int bestCount = 0;
+    int missing = 0;
+    for (int s = 0; s < m.shardCount; s++) {
+        ShardResult r;
+        if (!readShardResult(dir, &m, s, &r)) {
+            printf("Shard %d has no valid result\n", s);
+            missing++;
+            continue;
+        }
+        if (censusPath && !r.hasCensus) {
+            printf("Shard %d was run without --census\n", s);
+            missing++;
+            continue;
+        }
+        total.covered += r.total.covered;
+        total.orbits  += r.total.orbits;
+        for (int l = 0; l <= MAX_LENGTH; l++)
+            histogram[l] += r.histogram[l];
+        for (size_t k = 0; censusPath && k < CENSUS_SIZE; k++)
+            census[k] += r.census[k];
+
+        // the best states of every shard that reaches the maximum
+        if (r.total.maxLength > total.maxLength) {
+            total.maxLength = r.total.maxLength;
+            bestCount = 0;
+        }
+        if (r.total.maxLength == total.maxLength)
+            best[bestCount++] = r.total.bestState;
+    }
+    if (missing) {
+        printf("%d of %d shards are missing; not merging.\n", missing, m.shardCount);
+        free(census);
+        free(best);
+        return 1;
+    }
+
+    printf("n = %d, %d shards\n", m.n, m.shardCount);
+    // covered wraps to 0 for n = 8, where there are 2^64 states
+    printf("Orbits = %llu (covering %llu states)\n",
+           (unsigned long long)total.orbits, (unsigned long long)total.covered);
+    printf("Max length = %d\n", total.maxLength);
+    for (int i = 0; i < bestCount; i++) {
+        int seen = 0;
+        for (int k = 0; k < i; k++)
+            seen |= (best[k] == best[i]);
+        if (seen)
+            continue;
+        printf("Best state = %" PRIu64 "\n", best[i]);
+        water_print(&g_ctx, best[i]);
+    }
+    printHistogram(histogram);
+
+    int status = 0;
+    if (censusPath) {
+        if (writeCensus(censusPath, census)) {
+            printf("Census written to %s\n", censusPath);
+        } else {
+            printf("Could not write census %s\n", censusPath);
+            status = 1;
+        }
+    }
+    free(census);
+    free(best);
+    return status;
+}
+
+// ---------------------------------------------------------------------
+// Self-check (run as "multithreaded --self-check")
+//
+// Runs a sharded search for n = 3..5 in a scratch directory under
+// $TMPDIR (this program exec'd again), merges it in a forked child whose
+// stdout comes back through a pipe, and checks the merged report: the
+// maximum against a full enumeration, and every printed grid against the
+// best state above it.
+// ---------------------------------------------------------------------
+#ifndef _WIN32
+// The grid water_print() draws for 'state', one line per entry of 'lines'
+static void expectedGrid(uint64_t state, int n, char lines[WATER_MAX_N + 2][2 * WATER_MAX_N + 8]) {
+    char* border = lines[0];
+    int k = 0;
+    border[k++] = '+';
+    for (int i = 0; i < 2 * n + 1; i++)
+        border[k++] = '-';
+    border[k++] = '+';
+    border[k] = '\0';
+    for (int y = 0; y < n; y++) {
+        char* row = lines[y + 1];
+        k = 0;
+        row[k++] = '|';
+        for (int x = 0; x < n; x++) {
+            row[k++] = ' ';
+            row[k++] = water_isFilled(state, y * n + x) ? 'W' : '.';
+        }
+        row[k++] = ' ';
+        row[k++] = '|';
+        row[k] = '\0';
+    }
+    strcpy(lines[n + 1], border);
+}
 
+// Path to exec this program again: /proc/self/exe where there is one,
+// else argv[0] resolved (which fails for a bare name found on PATH)
+static int selfPath(const char* argv0, char* path, size_t size) {
+    if (access("/proc/self/exe", X_OK) == 0) {
+        snprintf(path, size, "/proc/self/exe");
+        return 1;
+    }
+    char resolved[PATH_MAX];
+    if (!strchr(argv0, '/') || !realpath(argv0, resolved))
+        return 0;
+    snprintf(path, size, "%s", resolved);
+    return 1;
+}
+
+// Run this program with 'args', feeding 'input' on stdin and throwing
+// its stdout away; returns 1 if it exits with status 0
+static int runSelf(const char* self, char* const args[], const char* input) {
+    int in[2];
+    if (pipe(in) != 0)
+        return 0;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(in[0], STDIN_FILENO);
+        dup2(devNull, STDOUT_FILENO);
+        close(in[0]);
+        close(in[1]);
+        execv(self, args);
+        _exit(127);
+    }
+    close(in[0]);
+    if (pid > 0 && write(in[1], input, strlen(input)) < 0)
+        pid = -1;
+    close(in[1]);
+    int status;
+    return pid > 0 && waitpid(pid, &status, 0) == pid
+        && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Remove the scratch directory and the files a sharded run leaves in it
+static void removeScratch(const char* dir) {
+    DIR* d = opendir(dir);
+    if (d) {
+        char path[4096 + 256];          // dir + '/' + a d_name
+        for (struct dirent* e; (e = readdir(d)) != NULL; ) {
+            if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+                continue;
+            snprintf(path, sizeof path, "%s/%s", dir, e->d_name);
+            unlink(path);
+        }
+        closedir(d);
+    }
+    if (rmdir(dir) != 0)
+        printf("Could not remove %s\n", dir);
+}
+
+static int checkMergeOn(const char* self, int n) {
+    const char* tmp = getenv("TMPDIR");
+    char dir[4096];
+    snprintf(dir, sizeof dir, "%s/water-selfcheck-XXXXXX", (tmp && *tmp) ? tmp : "/tmp");
+    if (!mkdtemp(dir)) {
+        printf("Could not create a scratch directory in %s\n", (tmp && *tmp) ? tmp : "/tmp");
+        return 0;
+    }
+
+    // The sharded run is a separate process, as in real use; the merge
+    // runs in a forked child, its report coming back through a pipe
+    char input[16];
+    snprintf(input, sizeof input, "%d\n", n);
+    char* shardArgs[] = { (char*)self, "--threads", "2", "--shard-dir", dir, "--shards", "3", NULL };
+    int ok = runSelf(self, shardArgs, input);
+    if (!ok)
+        printf("n = %d: the sharded run failed\n", n);
+
+    FILE* merged = NULL;
+    pid_t pid = -1;
+    int out[2];
+    if (ok && pipe(out) == 0) {
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0) {
+            dup2(out[1], STDOUT_FILENO);
+            close(out[0]);
+            close(out[1]);
+            int status = mergeShards(dir, NULL);
+            fflush(stdout);
+            _exit(status);
+        }
+        close(out[1]);
+        merged = (pid > 0) ? fdopen(out[0], "r") : NULL;
+        if (!merged)
+            close(out[0]);
+    }
+    if (ok && !merged) {
+        printf("n = %d: could not run the merge\n", n);
+        ok = 0;
+    }
+
+    water_init(&g_ctx, n, 0);
+    int expectedMax = 0;
+    for (uint64_t s = 0; s <= g_ctx.boardMask; s++) {
+        int length = water_length(&g_ctx, s);
+        if (length > expectedMax)
+            expectedMax = length;
+    }
+
+    int maxLength = -1, bestStates = 0;
+    char line[256];
+    while (ok && fgets(line, sizeof line, merged)) {
+        uint64_t state;
+        if (sscanf(line, "Max length = %d", &maxLength) == 1)
+            continue;
+        if (sscanf(line, "Best state = %" SCNu64, &state) != 1)
+            continue;
+        char grid[WATER_MAX_N + 2][2 * WATER_MAX_N + 8];
+        expectedGrid(state, n, grid);
+        for (int i = 0; ok && i < n + 2; i++) {
+            ok = fgets(line, sizeof line, merged) != NULL;
+            line[strcspn(line, "\n")] = '\0';
+            if (ok && strcmp(line, grid[i]) != 0) {
+                printf("n = %d: grid line %d of best state %" PRIu64 " is \"%s\", expected \"%s\"\n",
+                       n, i, state, line, grid[i]);
+                ok = 0;
+            }
+        }
+        if (ok && water_length(&g_ctx, state) != maxLength) {
+            printf("n = %d: best state %" PRIu64 " has length %d, not %d\n",
+                   n, state, water_length(&g_ctx, state), maxLength);
+            ok = 0;
+        }
+        bestStates++;
+    }
+    if (merged) {
+        fclose(merged);
+        int status;
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            if (ok)
+                printf("n = %d: --merge failed\n", n);
+            ok = 0;
+        }
+    }
+    if (ok && (maxLength != expectedMax || bestStates == 0)) {
+        printf("n = %d: merge reported max %d with %d best states, expected max %d\n",
+               n, maxLength, bestStates, expectedMax);
+        ok = 0;
+    }
+
+    removeScratch(dir);
+    return ok;
+}
+
+static int runSelfCheck(const char* argv0) {
+    char self[PATH_MAX];
+    if (!selfPath(argv0, self, sizeof self)) {
+        printf("Cannot find this program's own path to run it again\n");
+        return 1;
+    }
+    for (int n = 3; n <= 5; n++) {
+        if (!checkMergeOn(self, n))
+            return 1;
+        printf("n = %d: sharded run and merge OK\n", n);
+    }
+    printf("Self-check passed.\n");
     return 0;
 }
+#endif
+
+// ---------------------------------------------------------------------
+// main()
+// ---------------------------------------------------------------------
+int main(int argc, char **argv) {
+    // Choose how many threads to launch (default: every online core)
+    int threadCount = defaultThreadCount();
+    const char* checkpointPath = NULL;
+    const char* resumePath = NULL;
+    const char* shardDir = NULL;
+    int shardCount = 0;
+    int checkpointInterval = 60;
+    const char* telemetryTarget = NULL;
+    const char* censusPath = NULL;
+    const char* mergeDir = NULL;
+    int pinnedKernel = -1;
+    for (int a = 1; a < argc; a++) {
+        if ((strcmp(argv[a], "--threads") == 0 || strcmp(argv[a], "-t") == 0) && a + 1 < argc) {
+            threadCount = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--checkpoint") == 0 && a + 1 < argc) {
+            checkpointPath = argv[++a];
+        } else if (strcmp(argv[a], "--checkpoint-interval") == 0 && a + 1 < argc) {
+            checkpointInterval = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--resume") == 0 && a + 1 < argc) {
+            resumePath = argv[++a];
+        } else if (strcmp(argv[a], "--shard-dir") == 0 && a + 1 < argc) {
+            shardDir = argv[++a];
+        } else if (strcmp(argv[a], "--shards") == 0 && a + 1 < argc) {
+            shardCount = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--all-maximizers") == 0 && a + 1 < argc) {
+            g_maximizerPath = argv[++a];
+        } else if (strcmp(argv[a], "--telemetry") == 0 && a + 1 < argc) {
+            telemetryTarget = argv[++a];
+        } else if (strcmp(argv[a], "--telemetry-interval") == 0 && a + 1 < argc) {
+            g_telemetryInterval = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--prefilter") == 0 && a + 1 < argc) {
+            if (!parsePrefilter(argv[++a])) {
+                printf("Unknown prefilter rule list %s; the rules are all", argv[a]);
+                for (int r = 0; r < PREFILTER_RULES; r++)
+                    printf(", %s", g_prefilter[r].name);
+                printf("\n");
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--prefilter-verify") == 0) {
+            g_prefilterVerify = 1;
+        } else if (strcmp(argv[a], "--census") == 0 && a + 1 < argc) {
+            censusPath = argv[++a];
+        } else if (strcmp(argv[a], "--merge") == 0 && a + 1 < argc) {
+            mergeDir = argv[++a];
+        } else if (strcmp(argv[a], "--kernel") == 0 && a + 1 < argc) {
+            a++;
+            for (int isa = WATER_SCALAR; isa <= WATER_AVX512; isa++) {
+                if (strcmp(argv[a], water_isaName((WaterIsa)isa)) == 0)
+                    pinnedKernel = isa;
+            }
+            if (pinnedKernel < 0) {
+                printf("Unknown kernel %s; the kernels are scalar, avx2 and avx512\n", argv[a]);
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--self-check") == 0) {
+#ifdef _WIN32
+            printf("--self-check is only available on POSIX systems.\n");
+            return 1;
+#else
+            return runSelfCheck(argv[0]);
+#endif
+        } else {
+            printf("Usage: %s [--threads N] [--checkpoint FILE] [--checkpoint-interval SECS]\n"
+                   "       [--resume FILE] [--all-maximizers FILE] [--census FILE]\n"
+                   "       %s [--threads N] --shard-dir DIR [--shards K] [--census FILE]\n"
+                   "       %s --merge DIR [--census FILE]\n"
+                   "       %s --self-check\n"
+                   "Any run also takes [--telemetry FILE|unix:SOCKET] [--telemetry-interval SECS]\n"
+                   "and [--prefilter all|RULE,...] [--prefilter-verify]\n"
+                   "and [--kernel scalar|avx2|avx512]\n",
+                   argv[0], argv[0], argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (mergeDir)
+        return mergeShards(mergeDir, censusPath);
+    if (threadCount < 1) {
+        printf("Thread count must be at least 1.\n");
+        return 1;
+    }
+    if (g_prefilterVerify && !g_prefilterRules)
+        g_prefilterRules = (1 << PREFILTER_RULES) - 1;
+    if (g_prefilterRules && (censusPath || g_maximizerPath)) {
+        printf("--prefilter skips states without their length, so it does not combine\n"
+               "with --census or --all-maximizers.\n");
+        return 1;
+    }
+    if (g_prefilterVerify && (shardDir || resumePath)) {
+        printf("--prefilter-verify compares with the maximum of the whole run; it does\n"
+               "not combine with --shard-dir or --resume.\n");
+        return 1;
+    }
+    if (censusPath && (checkpointPath || resumePath)) {
+        printf("--census counts a whole run; checkpoints do not record it, so it does\n"
+               "not combine with --checkpoint or --resume.\n");
+        return 1;
+    }
+    if (g_maximizerPath && (checkpointPath || resumePath || shardDir)) {
+        printf("--all-maximizers needs a whole run in one process; it does not combine\n"
+               "with --checkpoint, --resume or --shard-dir.\n");
+        return 1;
+    }
+    if (shardDir && (checkpointPath || resumePath)) {
+        printf("Shard runs restart by shard; they do not take --checkpoint or --resume.\n");
+        return 1;
+    }
+#ifdef _WIN32
+    if (shardDir) {
+        printf("Shard runs need flock(), which this platform does not have.\n");
+        return 1;
+    }
+    if (telemetryTarget) {
+        printf("--telemetry is only available on POSIX systems.\n");
+        return 1;
+    }
+#else
+    g_telemetryStart = nowNanos();
+    if (telemetryTarget) {
+        g_telemetryFd = openTelemetry(telemetryTarget);
+        if (g_telemetryFd < 0) {
+            printf("Could not open telemetry target %s\n", telemetryTarget);
+            return 1;
+        }
+        g_telemetry = 1;
+    }
+#endif
+
+    // A resumed run keeps checkpointing to the file it resumed from
+    Checkpoint resumed = { 0, 0, 0, 0, NULL };
+    Manifest manifest = { 0, 0, 0, 0 };
+    int fixedDepth = -1;        // job depth imposed by a checkpoint or manifest
+    if (resumePath) {
+        if (!readCheckpoint(resumePath, &resumed)) {
+            printf("Could not read checkpoint %s\n", resumePath);
+            return 1;
+        }
+        if (!checkpointPath)
+            checkpointPath = resumePath;
+        g_n = resumed.n;
+        fixedDepth = resumed.jobDepth;
+        printf("Resuming n = %d from %s\n", g_n, resumePath);
+    } else if (shardDir && readManifest(shardDir, &manifest)) {
+        g_n = manifest.n;
+        fixedDepth = manifest.jobDepth;
+        printf("Joining n = %d, %d shards in %s\n", g_n, manifest.shardCount, shardDir);
+    } else {
+        if (shardDir && shardCount < 1) {
+            printf("%s has no manifest yet; give --shards K to create one.\n", shardDir);
+            return 1;
+        }
+        printf("Enter grid size (1 to 8): ");
+        if (scanf("%d", &g_n) != 1 || g_n < 1 || g_n > 8) {
+            printf("Invalid input.\n");
+            return 1;
+        }
+    }
+
+    // Step masks and the batch kernels to measure, then the symmetry orbits
+    if (water_init(&g_ctx, g_n, 0) != 0) {
+        printf("n = %d is outside 1..%d\n", g_n, WATER_MAX_N);
+        return 1;
+    }
+    if (!setKernels(pinnedKernel)) {
+        printf("This CPU or build has no %s kernel.\n", water_isaName((WaterIsa)pinnedKernel));
+        return 1;
+    }
+    printf("Batch kernel: %s, threads: %d\n", kernelDescription(), threadCount);
+    buildOrbits();
+    if (fixedDepth > g_orbitCount) {
+        printf("Job depth %d is past the %d orbits of n = %d.\n", fixedDepth, g_orbitCount, g_n);
+        return 1;
+    }
+
+    // Split off enough canonical prefixes to keep every thread busy. A
+    // resumed or sharded run must use the same split as the file it joins.
+    for (g_jobDepth = 0; g_jobDepth <= g_orbitCount; g_jobDepth++) {
+        if (fixedDepth >= 0 && g_jobDepth != fixedDepth)
+            continue;
+        g_jobCount = 0;
+        collectJobs(0, 0ULL, ALL_SYMMETRIES);
+        if (fixedDepth >= 0 || g_jobCount >= 64ULL * (uint64_t)threadCount || g_jobDepth == g_orbitCount)
+            break;
+    }
+    if (resumePath && g_jobCount != resumed.jobCount) {
+        printf("Checkpoint %s does not match this job layout.\n", resumePath);
+        return 1;
+    }
+
+    if (g_telemetryFd >= 0) {
+        TextBuf text = { NULL, 0, 0 };
+        textf(&text, "{\"event\":\"start\",\"t\":%.3f,\"n\":%d,\"threads\":%d,"
+                     "\"kernel\":\"%s\",\"jobs\":%llu,\"interval_s\":%.3f}",
+              telemetryTime(), g_n, threadCount, kernelDescription(),
+              (unsigned long long)g_jobCount, g_telemetryInterval);
+        sendTelemetry(&text);
+        free(text.data);
+    }
+
+#ifndef _WIN32
+    if (shardDir) {
+        if (fixedDepth < 0) {
+            manifest.n = g_n;
+            manifest.jobDepth = g_jobDepth;
+            manifest.jobCount = g_jobCount;
+            manifest.shardCount = shardCount;
+            if (!createManifest(shardDir, &manifest)) {
+                printf("Could not create %s/manifest\n", shardDir);
+                return 1;
+            }
+            // Another process may have created it first with its own layout
+            if (manifest.n != g_n) {
+                printf("%s/manifest is for n = %d\n", shardDir, manifest.n);
+                return 1;
+            }
+            if (manifest.jobDepth != g_jobDepth) {
+                g_jobDepth = manifest.jobDepth;
+                g_jobCount = 0;
+                collectJobs(0, 0ULL, ALL_SYMMETRIES);
+            }
+        }
+        if (g_jobCount != manifest.jobCount) {
+            printf("%s/manifest does not match this job layout.\n", shardDir);
+            return 1;
+        }
+        g_jobResults = (JobResult*)calloc(g_jobCount, sizeof(JobResult));
+        g_pending = (uint64_t*)malloc(sizeof(uint64_t) * (g_jobCount + 1));
+        int status = runShards(shardDir, &manifest, threadCount, censusPath != NULL);
+        // Whichever process finishes the last shard writes the census
+        int finished = 0;
+        for (int s = 0; s < manifest.shardCount; s++)
+            finished += shardFinished(shardDir, s);
+        if (status == 0 && censusPath && finished == manifest.shardCount)
+            status = mergeShards(shardDir, censusPath);
+        free(g_jobs);
+        free(g_jobResults);
+        free(g_pending);
+        return status;
+    }
+#endif
+
+    g_jobResults = (JobResult*)calloc(g_jobCount, sizeof(JobResult));
+    for (uint64_t r = 0; r < resumed.rangeCount; r++) {
+        for (uint64_t j = resumed.ranges[2 * r]; j < resumed.ranges[2 * r + 1]; j++) {
+            g_jobResults[j].thread = -1;
+            atomic_store(&g_jobResults[j].done, 1);
+        }
+    }
+    free(resumed.ranges);
+
+    g_pending = (uint64_t*)malloc(sizeof(uint64_t) * (g_jobCount + 1));
+    g_pendingCount = 0;
+    for (uint64_t j = 0; j < g_jobCount; j++) {
+        if (!atomic_load(&g_jobResults[j].done))
+            g_pending[g_pendingCount++] = j;
+    }
+
+    Totals total = g_resumed;
+    uint64_t histogram[MAX_LENGTH + 1] = { 0 };
+    uint64_t* census = censusPath ? (uint64_t*)calloc(CENSUS_SIZE, sizeof(uint64_t)) : NULL;
+    runPending(threadCount, checkpointPath, checkpointInterval, &total, histogram, census);
+
+    // Print results
+    printf("Orbits = %llu (covering %llu states)\n",
+           (unsigned long long)total.orbits, (unsigned long long)total.covered);
+    printf("Max length = %d\n", total.maxLength);
+    printf("Best state = %" PRIu64 "\n", total.bestState);
+    water_print(&g_ctx, total.bestState);
+
+    int status = 0;
+    if (g_prefilterRules) {
+        printf("Prefilter skipped");
+        for (int r = 0; r < PREFILTER_RULES; r++) {
+            if (g_prefilterRules & (1 << r))
+                printf(" %s: %llu", g_prefilter[r].name, (unsigned long long)g_prefilterSkipped[r]);
+        }
+        printf(" orbits\n");
+    }
+    if (g_prefilterVerify) {
+        if (g_prefilterSkippedMax > total.maxLength) {
+            printf("Prefilter check FAILED: skipped state %" PRIu64 " has length %d\n",
+                   g_prefilterSkippedState, g_prefilterSkippedMax);
+            status = 1;
+        } else {
+            printf("Prefilter check: the longest skipped state has length %d <= %d\n",
+                   g_prefilterSkippedMax, total.maxLength);
+        }
+    }
+    if (censusPath) {
+        printHistogram(histogram);
+        if (writeCensus(censusPath, census)) {
+            printf("Census written to %s\n", censusPath);
+        } else {
+            printf("Could not write census %s\n", censusPath);
+            status = 1;
+        }
+        free(census);
+    }
+
+    free(g_jobs);
+    free(g_jobResults);
+    free(g_pending);
+
+    return status;
+}
@@ -3,338 +3,419 @@
 #include <string.h>
 #include <limits.h>
 #include <inttypes.h>
-#include <time.h>      // for time(), difftime()
+#include <time.h>      // for clock_gettime()
 
-static int g_n = 0;             
-static uint64_t neighborMask[64];
-
-static inline int popcount64(uint64_t x) {
-    return __builtin_popcountll(x); // or implement your own
-}
-
-static inline int cellIndex(int x, int y) {
-    return y * g_n + x;
-}
-
-static inline int isFilled(uint64_t state, int idx) {
-    return (state >> idx) & 1ULL;
-}
+#include "../core/wide_board.h"
+#include "../core/water.h"
 
-static inline void fillCell(uint64_t *state, int idx) {
-    *state |= (1ULL << idx);
-}
-
-// Build neighbor masks for each cell
-static void buildNeighborMasks(void) {
-    memset(neighborMask, 0, sizeof(neighborMask));
-    for (int y = 0; y < g_n; y++) {
-        for (int x = 0; x < g_n; x++) {
-            int c = cellIndex(x, y);
-            // Up
-            if (y > 0)
-                neighborMask[c] |= (1ULL << cellIndex(x, y - 1));
-            // Down
-            if (y < g_n - 1)
-                neighborMask[c] |= (1ULL << cellIndex(x, y + 1));
-            // Left
-            if (x > 0)
-                neighborMask[c] |= (1ULL << cellIndex(x - 1, y));
-            // Right
-            if (x < g_n - 1)
-                neighborMask[c] |= (1ULL << cellIndex(x + 1, y));
-        }
-    }
-}
+static int g_n = 0;             
+static WaterContext g_ctx;      // masks and kernels for g_n
 
-// ------------------------------
-// 1) Rotate 90° (clockwise)
-//    (x,y) -> (newX,newY) = (n-1 - y, x)
-// ------------------------------
-uint64_t rotate90(uint64_t state) {
+// Per-cell version of the D4 transforms, kept for --self-check.
+// k = 0..7 follows the order of water_frameImages().
+static uint64_t transformReference(uint64_t state, int k) {
     uint64_t out = 0ULL;
     for (int y = 0; y < g_n; y++) {
         for (int x = 0; x < g_n; x++) {
-            int oldPos = cellIndex(x, y);
-            if (isFilled(state, oldPos)) {
-                int newX = g_n - 1 - y;
-                int newY = x;
-                int newPos = cellIndex(newX, newY);
-                fillCell(&out, newPos);
-            }
+            if (!water_isFilled(state, water_cellIndex(&g_ctx, x, y)))
+                continue;
+            int nx = x, ny = y;
+            if (k & 1) nx = g_n - 1 - nx;           // mirror
+            if (k & 2) ny = g_n - 1 - ny;           // flip rows
+            if (k & 4) { int t = nx; nx = ny; ny = t; } // transpose
+            water_fillCell(&out, water_cellIndex(&g_ctx, nx, ny));
         }
     }
     return out;
 }
 
-// ------------------------------
-// 2) Rotate 180°
-//    (x,y) -> (n-1 - x, n-1 - y)
-// ------------------------------
-uint64_t rotate180(uint64_t state) {
-    uint64_t out = 0ULL;
-    for (int y = 0; y < g_n; y++) {
-        for (int x = 0; x < g_n; x++) {
-            int oldPos = cellIndex(x, y);
-            if (isFilled(state, oldPos)) {
-                int newX = g_n - 1 - x;
-                int newY = g_n - 1 - y;
-                int newPos = cellIndex(newX, newY);
-                fillCell(&out, newPos);
+// Reference per-cell step, kept to cross-check the whole-board kernel
+static int iteration_step_reference(uint64_t *state) {
+    uint64_t old_state = *state;
+    int changed = 0;
+    for (int c = 0; c < g_n*g_n; c++) {
+        if (!water_isFilled(old_state, c)) {
+            int count_neighbors = water_popcount(old_state & g_ctx.neighborMask[c]);
+            if (count_neighbors >= 2) {
+                water_fillCell(state, c);
+                changed = 1;
             }
         }
     }
-    return out;
+    return changed;
 }
 
-// ------------------------------
-// 3) Rotate 270° (clockwise)
-//    (x,y) -> (newX,newY) = (y, n-1 - x)
-// ------------------------------
-uint64_t rotate270(uint64_t state) {
-    uint64_t out = 0ULL;
-    for (int y = 0; y < g_n; y++) {
-        for (int x = 0; x < g_n; x++) {
-            int oldPos = cellIndex(x, y);
-            if (isFilled(state, oldPos)) {
-                int newX = y;
-                int newY = g_n - 1 - x;
-                int newPos = cellIndex(newX, newY);
-                fillCell(&out, newPos);
-            }
+// Evaluate a batch and fold it into the running maximum
+static void evaluateBatch(const uint64_t *batch, size_t count,
+                          int *maxLength, uint64_t *bestState) {
+    int lengths[WATER_BATCH_SIZE];
+    water_lengths(&g_ctx, batch, lengths, count);
+    for (size_t i = 0; i < count; i++) {
+        if (lengths[i] > *maxLength) {
+            *maxLength = lengths[i];
+            *bestState = batch[i];
         }
     }
-    return out;
 }
 
 // ------------------------------
-// 4) Reflect horizontally (flip top <-> bottom)
-//    (x,y) -> (x, n-1 - y)
+// Self-check (run as "simple --self-check")
+//
+// Compares the whole-board step against the per-cell reference for
+// n = 1..8. Every state is tried for n <= 5; for larger n every pattern of
+// each cell's 5-cell neighbourhood is tried over random backgrounds, which
+// covers everything a single cell's update can depend on.
 // ------------------------------
-uint64_t reflectHorizontal(uint64_t state) {
-    uint64_t out = 0ULL;
-    for (int y = 0; y < g_n; y++) {
-        for (int x = 0; x < g_n; x++) {
-            int oldPos = cellIndex(x, y);
-            if (isFilled(state, oldPos)) {
-                int newX = x;
-                int newY = g_n - 1 - y;
-                int newPos = cellIndex(newX, newY);
-                fillCell(&out, newPos);
-            }
-        }
+static uint64_t xorshift64(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+static int checkStepOn(uint64_t state) {
+    uint64_t a = state, b = state;
+    int changedA = water_step(&g_ctx, &a);
+    int changedB = iteration_step_reference(&b);
+    if (a != b || changedA != changedB) {
+        printf("Step mismatch for n = %d, state = %" PRIu64 "\n", g_n, state);
+        return 0;
     }
-    return out;
+    return 1;
 }
 
-// ------------------------------
-// 5) Reflect vertically (flip left <-> right)
-//    (x,y) -> (n-1 - x, y)
-// ------------------------------
-uint64_t reflectVertical(uint64_t state) {
-    uint64_t out = 0ULL;
-    for (int y = 0; y < g_n; y++) {
-        for (int x = 0; x < g_n; x++) {
-            int oldPos = cellIndex(x, y);
-            if (isFilled(state, oldPos)) {
-                int newX = g_n - 1 - x;
-                int newY = y;
-                int newPos = cellIndex(newX, newY);
-                fillCell(&out, newPos);
-            }
+static int checkBatchKernel(WaterBatchKernel kernel, const char *name, uint64_t *rng) {
+    enum { COUNT = 4096 };
+    static uint64_t states[COUNT];
+    static int lengths[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        // mix sparse and dense boards so lengths vary a lot within a batch
+        uint64_t r = xorshift64(rng);
+        if (i & 1)
+            r &= xorshift64(rng) & xorshift64(rng);
+        states[i] = r & g_ctx.boardMask;
+    }
+    kernel(&g_ctx, states, lengths, COUNT);
+    for (int i = 0; i < COUNT; i++) {
+        if (lengths[i] != water_length(&g_ctx, states[i])) {
+            printf("Batch kernel %s mismatch for n = %d, state = %" PRIu64 "\n",
+                   name, g_n, states[i]);
+            return 0;
         }
     }
-    return out;
+    return 1;
 }
 
-// ------------------------------
-// 6) Reflect along main diagonal (top-left to bottom-right)
-//    (x,y) -> (y,x)
-// ------------------------------
-uint64_t reflectMainDiag(uint64_t state) {
-    uint64_t out = 0ULL;
-    for (int y = 0; y < g_n; y++) {
-        for (int x = 0; x < g_n; x++) {
-            int oldPos = cellIndex(x, y);
-            if (isFilled(state, oldPos)) {
-                // swap x,y
-                int newX = y;
-                int newY = x;
-                int newPos = cellIndex(newX, newY);
-                fillCell(&out, newPos);
-            }
+// The row-array board must agree with the packed one wherever both apply
+static int checkWideBoard(uint64_t *rng) {
+    for (int i = 0; i < 4096; i++) {
+        uint64_t state = xorshift64(rng) & xorshift64(rng) & g_ctx.boardMask;
+        WideBoard b = wb_fromPacked(state, g_n);
+
+        uint64_t next = state;
+        water_step(&g_ctx, &next);
+        wb_step(&b, g_n);
+        if (wb_toPacked(&b, g_n) != next) {
+            printf("Wide step mismatch for n = %d, state = %" PRIu64 "\n", g_n, state);
+            return 0;
+        }
+
+        if (wb_compute_length_frontier(wb_fromPacked(state, g_n), g_n) != water_length(&g_ctx, state)) {
+            printf("Wide frontier length mismatch for n = %d, state = %" PRIu64 "\n", g_n, state);
+            return 0;
+        }
+
+        WideBoard canonical;
+        b = wb_fromPacked(state, g_n);
+        wb_canonical(&b, g_n, &canonical);
+        if (wb_toPacked(&canonical, g_n) != water_canonical(&g_ctx, state, NULL)) {
+            printf("Wide canonical mismatch for n = %d, state = %" PRIu64 "\n", g_n, state);
+            return 0;
         }
     }
-    return out;
+    return 1;
 }
 
-// ------------------------------
-// 7) Reflect along anti-diagonal (top-right to bottom-left)
-//    (x,y) -> (n-1 - y, n-1 - x)
-// ------------------------------
-uint64_t reflectAntiDiag(uint64_t state) {
-    uint64_t out = 0ULL;
-    for (int y = 0; y < g_n; y++) {
-        for (int x = 0; x < g_n; x++) {
-            int oldPos = cellIndex(x, y);
-            if (isFilled(state, oldPos)) {
-                int newX = g_n - 1 - y;
-                int newY = g_n - 1 - x;
-                int newPos = cellIndex(newX, newY);
-                fillCell(&out, newPos);
+// Frontier lengths against full steps on boards too big to pack: random
+// sparse boards and a long snake (row 0 full, triggers on alternate sides)
+static int checkWideFrontier(uint64_t *rng) {
+    for (int n = 9; n <= WB_MAX_N; n++) {
+        for (int i = 0; i < 512; i++) {
+            WideBoard b;
+            wb_clear(&b);
+            int cells = 1 + (int)(xorshift64(rng) % (uint64_t)(2 * n));
+            for (int c = 0; c < cells; c++)
+                wb_fillCell(&b, (int)(xorshift64(rng) % (uint64_t)n), (int)(xorshift64(rng) % (uint64_t)n));
+            if (wb_compute_length_frontier(b, n) != wb_compute_length(b, n)) {
+                printf("Wide frontier length mismatch for n = %d\n", n);
+                return 0;
             }
         }
+
+        WideBoard snake;
+        wb_clear(&snake);
+        snake.row[0] = wb_rowMask(n);
+        for (int y = 2, side = 0; y < n; y += 2, side ^= 1)
+            wb_fillCell(&snake, side ? n - 1 : 0, y);
+        if (wb_compute_length_frontier(snake, n) != wb_compute_length(snake, n)) {
+            printf("Wide frontier length mismatch for the n = %d snake\n", n);
+            return 0;
+        }
     }
-    return out;
+    return 1;
 }
 
-// ------------------------------
-// getCanonicalRep
-//
-// 1) Generate all 8 transformations of 'state'.
-// 2) Take the minimum numerical value among them.
-// 3) Return that as the canonical representative.
-// ------------------------------
-uint64_t getCanonicalRep(uint64_t state) {
-    // Compute all 8 transformations
-    uint64_t t[8];
-    t[0] = state;                      // identity
-    t[1] = rotate90(state);
-    t[2] = rotate180(state);
-    t[3] = rotate270(state);
-    t[4] = reflectHorizontal(state);
-    t[5] = reflectVertical(state);
-    t[6] = reflectMainDiag(state);
-    t[7] = reflectAntiDiag(state);
-
-    // Pick the minimum
-    uint64_t best = t[0];
-    for (int i = 1; i < 8; i++) {
-        if (t[i] < best) {
-            best = t[i];
+// Every batch kernel the library has for g_n, generic and specialised,
+// and the specialised canonical kernel against the generic one
+static int checkLibraryKernels(uint64_t *rng) {
+    for (int isa = WATER_SCALAR; isa <= WATER_AVX512; isa++) {
+        for (int specialised = 0; specialised <= 1; specialised++) {
+            WaterBatchKernel kernel = water_batchKernel(g_n, (WaterIsa)isa, specialised);
+            if (!kernel)
+                continue;           // not on this CPU
+            char name[64];
+            snprintf(name, sizeof(name), "%s%s", water_isaName((WaterIsa)isa),
+                     specialised ? " (fixed n)" : "");
+            if (!checkBatchKernel(kernel, name, rng))
+                return 0;
         }
     }
-    return best;
+    WaterCanonicalKernel generic = water_canonicalKernel(g_n, 0);
+    WaterCanonicalKernel fixed = water_canonicalKernel(g_n, 1);
+    for (int i = 0; i < 100000; i++) {
+        uint64_t state = xorshift64(rng) & g_ctx.boardMask;
+        if (i & 1)
+            state &= xorshift64(rng);
+        int expected, got;
+        if (fixed(&g_ctx, state, &got) != generic(&g_ctx, state, &expected)
+            || got != expected) {
+            printf("Fixed canonical rep mismatch for n = %d, state = %" PRIu64 "\n", g_n, state);
+            return 0;
+        }
+    }
+    return 1;
 }
 
-// One iteration step; returns 1 if any cell changed
-static int iteration_step(uint64_t *state) {
-    uint64_t old_state = *state;
-    int changed = 0;
-    for (int c = 0; c < g_n*g_n; c++) {
-        if (!isFilled(old_state, c)) {
-            int count_neighbors = popcount64(old_state & neighborMask[c]);
-            if (count_neighbors >= 2) {
-                fillCell(state, c);
-                changed = 1;
-            }
+// Every transform and the canonical rep against the per-cell version
+static int checkTransformsOn(uint64_t state) {
+    uint64_t best = state;
+    int same = 0;
+    for (int k = 0; k < 8; k++) {
+        uint64_t expected = transformReference(state, k);
+        if (water_transform(&g_ctx, state, k) != expected) {
+            printf("Transform %d mismatch for n = %d, state = %" PRIu64 "\n", k, g_n, state);
+            return 0;
         }
+        if (expected < best)
+            best = expected;
+        same += (expected == state);
     }
-    return changed;
+    int stabilizer;
+    if (water_canonicalKernel(g_n, 0)(&g_ctx, state, &stabilizer) != best || stabilizer != same) {
+        printf("Canonical rep mismatch for n = %d, state = %" PRIu64 "\n", g_n, state);
+        return 0;
+    }
+    return 1;
 }
 
-// Compute steps until the grid stabilizes
-static int compute_length(uint64_t initialState) {
-    uint64_t state = initialState;
-    int steps = 1;
-    while (iteration_step(&state)) {
-        steps++;
+static int checkTransforms(uint64_t *rng) {
+    if (g_n <= 4) {
+        for (uint64_t state = 0ULL; state < (1ULL << (g_n*g_n)); state++) {
+            if (!checkTransformsOn(state))
+                return 0;
+        }
+        return 1;
+    }
+    for (int i = 0; i < 100000; i++) {
+        uint64_t state = xorshift64(rng) & g_ctx.boardMask;
+        if (i & 1)
+            state &= xorshift64(rng);
+        if (!checkTransformsOn(state))
+            return 0;
     }
-    return steps;
+    return 1;
 }
 
-static void printGrid(uint64_t state) {
-    // Top boundary
-    printf("+");
-    for (int i = 0; i < g_n * 2 + 1; i++) {
-        printf("-");
+// Incrementally updated images must match the ones computed from scratch
+static int checkGrayImages(void) {
+    uint64_t limit = (g_n*g_n <= 20) ? (1ULL << (g_n*g_n)) : (1ULL << 20);
+    uint64_t state = 0ULL;
+    uint64_t t[8] = {0};
+    for (uint64_t i = 0ULL; i < limit; i++) {
+        if (i > 0) {
+            int c = __builtin_ctzll(i);
+            state ^= 1ULL << c;
+            water_grayFlip(&g_ctx, t, c);
+        }
+        uint64_t expected[8];
+        water_frameImages(&g_ctx, water_toFrame(&g_ctx, state), expected);
+        if (memcmp(t, expected, sizeof(expected)) != 0) {
+            printf("Gray-code images mismatch for n = %d, state = %" PRIu64 "\n", g_n, state);
+            return 0;
+        }
     }
-    printf("+\n");
+    return 1;
+}
 
-    // Rows
-    for (int y = 0; y < g_n; y++) {
-        printf("|");
-        for (int x = 0; x < g_n; x++) {
-            int c = cellIndex(x, y);
-            if (isFilled(state, c)) {
-                printf(" W");
-            } else {
-                printf(" .");
+static int runSelfCheck(void) {
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    for (g_n = 1; g_n <= 8; g_n++) {
+        water_init(&g_ctx, g_n, 0);
+        if (g_n <= 5) {
+            uint64_t totalStates = (1ULL << (g_n*g_n));
+            for (uint64_t state = 0ULL; state < totalStates; state++) {
+                if (!checkStepOn(state))
+                    return 1;
+            }
+        } else {
+            for (int c = 0; c < g_n*g_n; c++) {
+                uint64_t around = g_ctx.neighborMask[c] | (1ULL << c);
+                for (int round = 0; round < 256; round++) {
+                    uint64_t background = xorshift64(&rng) & g_ctx.boardMask & ~around;
+                    // walk every subset of the neighbourhood
+                    uint64_t sub = 0ULL;
+                    do {
+                        if (!checkStepOn(background | sub))
+                            return 1;
+                        sub = (sub - around) & around;
+                    } while (sub != 0ULL);
+                }
             }
         }
-        printf(" |\n");
-    }
+        printf("n = %d: step kernel OK\n", g_n);
 
-    // Bottom boundary
-    printf("+");
-    for (int i = 0; i < g_n * 2 + 1; i++) {
-        printf("-");
+        if (!checkLibraryKernels(&rng))
+            return 1;
+        printf("n = %d: batch and specialised kernels OK\n", g_n);
+
+        if (!checkTransforms(&rng))
+            return 1;
+        printf("n = %d: transforms OK\n", g_n);
+
+        if (!checkGrayImages())
+            return 1;
+        printf("n = %d: Gray-code images OK\n", g_n);
+
+        if (!checkWideBoard(&rng))
+            return 1;
+        printf("n = %d: wide board OK\n", g_n);
     }
-    printf("+\n");
+
+    if (!checkWideFrontier(&rng))
+        return 1;
+    printf("n = 9..%d: wide frontier OK\n", WB_MAX_N);
+    return 0;
 }
 
-int main(void) {
+int main(int argc, char **argv) {
+    int grayOrder = 0;
+    int generic = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--self-check") == 0) {
+            return runSelfCheck();
+        } else if (strcmp(argv[a], "--gray") == 0) {
+            grayOrder = 1;      // enumerate in Gray-code order
+        } else if (strcmp(argv[a], "--generic") == 0) {
+            generic = 1;        // kernels that read n at run time
+        } else {
+            printf("Usage: %s [--gray] [--generic] [--self-check]\n", argv[0]);
+            return 1;
+        }
+    }
+
     printf("Enter grid size (1 to 8): ");
     if (scanf("%d", &g_n) != 1 || g_n < 1 || g_n > 8) {
         printf("Invalid input. Please run again with n between 1 and 8.\n");
         return 1;
     }
 
-    buildNeighborMasks();
+    water_init(&g_ctx, g_n, generic ? WATER_GENERIC : 0);
+    printf("Batch kernel: %s\n", water_kernelName(&g_ctx));
 
     uint64_t totalStates = (1ULL << (g_n*g_n));
     int maxLength = 0;
     uint64_t bestState = 0ULL;
+    uint64_t orbitCount = 0ULL;     // canonical states evaluated
+    uint64_t coveredStates = 0ULL;  // sum of their orbit sizes
 
     // Progress settings
     const uint64_t progressInterval = 10000000ULL; // print progress every 10 million states
 
-    // Timing
-    time_t startTime = time(NULL);
+    // Canonical states are queued and evaluated a batch at a time
+    uint64_t batch[WATER_BATCH_SIZE];
+    size_t batchCount = 0;
+
+    // Timing (monotonic, so the ETA survives clock adjustments)
+    struct timespec startTime;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
 
-    for (uint64_t state = 0ULL; state < totalStates; state++) {
+    uint64_t state = 0ULL;
+    uint64_t image[8] = {0};   // frame images of state (Gray-code order only)
+
+    for (uint64_t i = 0ULL; i < totalStates; i++) {
         // Show progress occasionally
-        if ((state % progressInterval) == 0ULL && state > 0) {
-            time_t now = time(NULL);
-            double elapsedSecs = difftime(now, startTime);
+        if ((i % progressInterval) == 0ULL && i > 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            double elapsedSecs = (double)(now.tv_sec - startTime.tv_sec)
+                               + 1e-9 * (double)(now.tv_nsec - startTime.tv_nsec);
 
             // States per second, skipping if elapsedSecs is zero or extremely small
             if (elapsedSecs > 0.0) {
-                double sps        = (double)state / elapsedSecs; // states per second
-                double statesLeft = (double)(totalStates - state);
+                double sps        = (double)i / elapsedSecs; // states per second
+                double statesLeft = (double)(totalStates - i);
                 double secsLeft   = statesLeft / sps;
                 double minsLeft   = secsLeft / 60.0;
-                double percent    = 100.0 * (double)state / (double)totalStates;
+                double percent    = 100.0 * (double)i / (double)totalStates;
 
-                printf("Progress: %llu / %llu (%.2f%%), approx %.1f minutes left\n",
-                       (unsigned long long)state,
+                printf("Progress: %llu / %llu (%.2f%%), %.3g states/s, approx %.1f minutes left\n",
+                       (unsigned long long)i,
                        (unsigned long long)totalStates,
-                       percent, minsLeft);  
+                       percent, sps, minsLeft);
             } else {
                 // If elapsedSecs is still 0, we can't compute time left safely
                 printf("Progress: %llu / %llu\n",
-                       (unsigned long long)state,
+                       (unsigned long long)i,
                        (unsigned long long)totalStates);
             }
         }
 
-        uint64_t canonical = getCanonicalRep(state);
-        if (state != canonical) {
+        int stabilizer;
+        int isCanonical;
+        if (grayOrder) {
+            // i-th Gray code: flip the cell at the lowest set bit of i
+            if (i > 0) {
+                int c = __builtin_ctzll(i);
+                state ^= 1ULL << c;
+                water_grayFlip(&g_ctx, image, c);
+            }
+            isCanonical = (water_minImage(image, &stabilizer) == image[0]);
+        } else {
+            state = i;
+            isCanonical = (water_canonical(&g_ctx, state, &stabilizer) == state);
+        }
+        if (!isCanonical) {
             // we can skip all noncanonical states
             // since they will be covered by symmetry
             continue;
         }
+        orbitCount++;
+        coveredStates += (uint64_t)(8 / stabilizer);
 
-        int length = compute_length(state);
-        if (length > maxLength) {
-            maxLength = length;
-            bestState = state;
+        batch[batchCount++] = state;
+        if (batchCount == WATER_BATCH_SIZE) {
+            evaluateBatch(batch, batchCount, &maxLength, &bestState);
+            batchCount = 0;
         }
     }
+    evaluateBatch(batch, batchCount, &maxLength, &bestState);
 
     // Final report
+    printf("Orbits = %llu (covering %llu states)\n",
+           (unsigned long long)orbitCount, (unsigned long long)coveredStates);
     printf("Max length = %d\n", maxLength);
     printf("Best state = %" PRIu64 "\n", bestState);
-    printGrid(bestState);
+    water_print(&g_ctx, bestState);
 
     return 0;
 }
@@ -0,0 +1,607 @@
+/*
+  Batch, canonical and transform kernels behind water.h.
+
+  Batch evaluation: the SIMD kernels keep one board per vector lane; when
+  a lane's board stops changing its length is written out and the lane is
+  refilled from the input, so lanes never sit idle waiting for a
+  long-running neighbour.
+
+  Kernels specialised per n: the generic kernels read n and the masks from
+  the context. The *Fixed versions take n as a parameter and are always
+  inlined, and INSTANTIATE_KERNELS(N) stamps out a copy for each
+  n = 1..8. Inside a copy n is a literal, so the masks fold to immediates,
+  the shifts by n take immediate operands, and the frame compress/expand
+  stages that are zero for this n disappear. water_init() uses them unless
+  asked for WATER_GENERIC.
+
+  Scalar by default: wider is not faster here. The enumeration's boards
+  settle in a few steps, so the vector kernels spend much of their time
+  refilling lanes, and on Gray-code runs like the enumeration's the
+  scalar copy for n was 10-40% ahead of AVX2 and AVX-512 at n = 4..7.
+  Which kernel wins depends on n, the boards and the CPU (AVX-512 can lead
+  at n = 8), too much so for a quick measurement on made-up boards to
+  call, and benchmarks that replay one batch flatter the SIMD kernels,
+  since the branch predictor learns when their lanes refill. WATER_SIMD
+  asks for the widest SIMD kernel; the enumeration in multithreaded.c
+  times the kernels on its own batches instead.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "water.h"
+
+// ---------------------------------------------------------------------
+// Generic kernels
+// ---------------------------------------------------------------------
+static void lengthsScalar(const WaterContext *ctx, const uint64_t *states,
+                          int *lengths, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        lengths[i] = water_length(ctx, states[i]);
+    }
+}
+
+static uint64_t canonicalGeneric(const WaterContext *ctx, uint64_t state, int *stabilizer) {
+    uint64_t t[8];
+    water_frameImages(ctx, water_toFrame(ctx, state), t);
+    return water_fromFrame(ctx, water_minImage(t, stabilizer));
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// Lane bookkeeping after the vector loop stopped because at least one lane
+// converged (bit l of doneMask). Converged lanes report their length and take
+// the next input; returns 0 once the input is used up, after finishing the
+// remaining lanes on the scalar path.
+static int refillLanes(const WaterContext *ctx, int laneCount, unsigned doneMask,
+                       uint64_t *lane, uint64_t *steps, size_t *idx,
+                       const uint64_t *states, int *lengths,
+                       size_t count, size_t *next) {
+    for (int l = 0; l < laneCount; l++) {
+        if (!(doneMask & (1u << l))) {
+            steps[l]++;              // this lane advanced one more generation
+            continue;
+        }
+        lengths[idx[l]] = (int)steps[l];
+        if (*next < count) {
+            lane[l]  = states[*next];
+            steps[l] = 1;
+            idx[l]   = (*next)++;
+        } else {
+            idx[l] = SIZE_MAX;
+        }
+    }
+    if (*next < count)
+        return 1;
+
+    for (int l = 0; l < laneCount; l++) {
+        if (idx[l] != SIZE_MAX) {
+            lengths[idx[l]] = (int)steps[l] + water_length(ctx, lane[l]) - 1;
+        }
+    }
+    return 0;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i stepAvx2(__m256i s, __m256i nfc, __m256i nlc,
+                               __m256i bm, __m128i shiftN) {
+    __m256i left  = _mm256_and_si256(_mm256_slli_epi64(s, 1), nfc);
+    __m256i right = _mm256_and_si256(_mm256_srli_epi64(s, 1), nlc);
+    __m256i up    = _mm256_sll_epi64(s, shiftN);
+    __m256i down  = _mm256_srl_epi64(s, shiftN);
+    __m256i two   = _mm256_or_si256(
+        _mm256_or_si256(_mm256_and_si256(left, right), _mm256_and_si256(up, down)),
+        _mm256_and_si256(_mm256_or_si256(left, right), _mm256_or_si256(up, down)));
+    return _mm256_or_si256(s, _mm256_and_si256(two, bm));
+}
+
+// 2 x 4 lanes: two independent vectors keep both ALU ports busy
+__attribute__((target("avx2")))
+static void lengthsAvx2(const WaterContext *ctx, const uint64_t *states,
+                        int *lengths, size_t count) {
+    enum { LANES = 8 };
+    if (count < LANES) {
+        lengthsScalar(ctx, states, lengths, count);
+        return;
+    }
+    uint64_t lane[LANES]  __attribute__((aligned(32)));
+    uint64_t steps[LANES] __attribute__((aligned(32)));
+    size_t idx[LANES];
+    size_t next = 0;
+    for (int l = 0; l < LANES; l++) {
+        lane[l] = states[next];
+        steps[l] = 1;
+        idx[l] = next++;
+    }
+
+    const __m256i nfc = _mm256_set1_epi64x((long long)ctx->notFirstCol);
+    const __m256i nlc = _mm256_set1_epi64x((long long)ctx->notLastCol);
+    const __m256i bm  = _mm256_set1_epi64x((long long)ctx->boardMask);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m128i shiftN = _mm_cvtsi32_si128(ctx->n);
+    unsigned done;
+
+    do {
+        __m256i s0 = _mm256_load_si256((const __m256i *)&lane[0]);
+        __m256i s1 = _mm256_load_si256((const __m256i *)&lane[4]);
+        __m256i c0 = _mm256_load_si256((const __m256i *)&steps[0]);
+        __m256i c1 = _mm256_load_si256((const __m256i *)&steps[4]);
+        for (;;) {
+            __m256i n0 = stepAvx2(s0, nfc, nlc, bm, shiftN);
+            __m256i n1 = stepAvx2(s1, nfc, nlc, bm, shiftN);
+            unsigned m0 = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(n0, s0)));
+            unsigned m1 = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(n1, s1)));
+            s0 = n0;
+            s1 = n1;
+            done = m0 | (m1 << 4);
+            if (done)
+                break;
+            c0 = _mm256_add_epi64(c0, one);
+            c1 = _mm256_add_epi64(c1, one);
+        }
+        _mm256_store_si256((__m256i *)&lane[0], s0);
+        _mm256_store_si256((__m256i *)&lane[4], s1);
+        _mm256_store_si256((__m256i *)&steps[0], c0);
+        _mm256_store_si256((__m256i *)&steps[4], c1);
+    } while (refillLanes(ctx, LANES, done, lane, steps, idx, states, lengths, count, &next));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i stepAvx512(__m512i s, __m512i nfc, __m512i nlc,
+                                 __m512i bm, __m128i shiftN) {
+    __m512i left  = _mm512_and_si512(_mm512_slli_epi64(s, 1), nfc);
+    __m512i right = _mm512_and_si512(_mm512_srli_epi64(s, 1), nlc);
+    __m512i up    = _mm512_sll_epi64(s, shiftN);
+    __m512i down  = _mm512_srl_epi64(s, shiftN);
+    // majority(left, right, up|down) | (up & down) == "at least two of four"
+    __m512i two = _mm512_ternarylogic_epi64(left, right, _mm512_or_si512(up, down), 0xE8);
+    two = _mm512_or_si512(two, _mm512_and_si512(up, down));
+    // s | (two & bm)
+    return _mm512_ternarylogic_epi64(s, two, bm, 0xF8);
+}
+
+// 2 x 8 lanes, 16 boards in flight
+__attribute__((target("avx512f")))
+static void lengthsAvx512(const WaterContext *ctx, const uint64_t *states,
+                          int *lengths, size_t count) {
+    enum { LANES = 16 };
+    if (count < LANES) {
+        lengthsScalar(ctx, states, lengths, count);
+        return;
+    }
+    uint64_t lane[LANES]  __attribute__((aligned(64)));
+    uint64_t steps[LANES] __attribute__((aligned(64)));
+    size_t idx[LANES];
+    size_t next = 0;
+    for (int l = 0; l < LANES; l++) {
+        lane[l] = states[next];
+        steps[l] = 1;
+        idx[l] = next++;
+    }
+
+    const __m512i nfc = _mm512_set1_epi64((long long)ctx->notFirstCol);
+    const __m512i nlc = _mm512_set1_epi64((long long)ctx->notLastCol);
+    const __m512i bm  = _mm512_set1_epi64((long long)ctx->boardMask);
+    const __m512i one = _mm512_set1_epi64(1);
+    const __m128i shiftN = _mm_cvtsi32_si128(ctx->n);
+    unsigned done;
+
+    do {
+        __m512i s0 = _mm512_load_si512(&lane[0]);
+        __m512i s1 = _mm512_load_si512(&lane[8]);
+        __m512i c0 = _mm512_load_si512(&steps[0]);
+        __m512i c1 = _mm512_load_si512(&steps[8]);
+        for (;;) {
+            __m512i n0 = stepAvx512(s0, nfc, nlc, bm, shiftN);
+            __m512i n1 = stepAvx512(s1, nfc, nlc, bm, shiftN);
+            unsigned m0 = _mm512_cmpeq_epi64_mask(n0, s0);
+            unsigned m1 = _mm512_cmpeq_epi64_mask(n1, s1);
+            s0 = n0;
+            s1 = n1;
+            done = m0 | (m1 << 8);
+            if (done)
+                break;
+            c0 = _mm512_add_epi64(c0, one);
+            c1 = _mm512_add_epi64(c1, one);
+        }
+        _mm512_store_si512(&lane[0], s0);
+        _mm512_store_si512(&lane[8], s1);
+        _mm512_store_si512(&steps[0], c0);
+        _mm512_store_si512(&steps[8], c1);
+    } while (refillLanes(ctx, LANES, done, lane, steps, idx, states, lengths, count, &next));
+}
+#endif
+
+// ---------------------------------------------------------------------
+// Kernels specialised per n
+// ---------------------------------------------------------------------
+#define FIXED_BOARD_MASK(n)    ((n) == 8 ? ~0ULL : ((1ULL << ((n) * (n))) - 1ULL))
+#define FIXED_FIRST_COL(n)     (FIXED_BOARD_MASK(n) / ((1ULL << (n)) - 1ULL))   // x == 0
+#define FIXED_NOT_FIRST_COL(n) (FIXED_BOARD_MASK(n) & ~FIXED_FIRST_COL(n))
+#define FIXED_NOT_LAST_COL(n)  (FIXED_BOARD_MASK(n) & ~(FIXED_FIRST_COL(n) << ((n) - 1)))
+#define FIXED_FRAME_MASK(n)    ((((1ULL << (n)) - 1ULL) * 0x0101010101010101ULL) \
+                                & ((n) == 8 ? ~0ULL : ((1ULL << (8 * (n))) - 1ULL)))
+
+// frameStage for each n, as water_init() computes it
+static const uint64_t fixedFrameStage[9][6] = {
+    { 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL },
+    { 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL },
+    { 0x0000000000000000ULL, 0x0000000000000300ULL, 0x00000000000000C0ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL },
+    { 0x0000000000000700ULL, 0x0000000000070000ULL, 0x0000000000000380ULL, 0x000000000001C000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL },
+    { 0x0000000000000000ULL, 0x0000000000000000ULL, 0x000000000F000F00ULL, 0x0000000000FF0000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL },
+    { 0x000000001F001F00ULL, 0x00000000001F0F80ULL, 0x0000001F0007C000ULL, 0x00000001FF800000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL },
+    { 0x0000000000000000ULL, 0x00003F003F003F00ULL, 0x000000000FFF0000ULL, 0x00000FFF00000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL },
+    { 0x00007F007F007F00ULL, 0x007F00003FFF0000ULL, 0x001FFFFF00000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL },
+    { 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL },
+};
+
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+
+ALWAYS_INLINE int lengthFixed(uint64_t state, const int n) {
+    int steps = 1;
+    for (;;) {
+        uint64_t next = water_next(state, n, FIXED_NOT_FIRST_COL(n),
+                                   FIXED_NOT_LAST_COL(n), FIXED_BOARD_MASK(n));
+        if (next == state)
+            return steps;
+        state = next;
+        steps++;
+    }
+}
+
+ALWAYS_INLINE void lengthsScalarFixed(const uint64_t *states, int *lengths,
+                                      size_t count, const int n) {
+    for (size_t i = 0; i < count; i++) {
+        lengths[i] = lengthFixed(states[i], n);
+    }
+}
+
+ALWAYS_INLINE uint64_t toFrameFixed(uint64_t state, const int n) {
+    uint64_t x = state;
+    for (int i = 5; i >= 0; i--) {
+        const uint64_t stage = fixedFrameStage[n][i];
+        if (stage) {
+            uint64_t t = x << (1 << i);
+            x = (x & ~stage) | (t & stage);
+        }
+    }
+    return x & FIXED_FRAME_MASK(n);
+}
+
+ALWAYS_INLINE uint64_t fromFrameFixed(uint64_t frame, const int n) {
+    uint64_t x = frame & FIXED_FRAME_MASK(n);
+    for (int i = 0; i < 6; i++) {
+        const uint64_t stage = fixedFrameStage[n][i];
+        if (stage) {
+            uint64_t t = x & stage;
+            x = (x ^ t) | (t >> (1 << i));
+        }
+    }
+    return x;
+}
+
+ALWAYS_INLINE uint64_t frameMirrorFixed(uint64_t f, const int n) {
+    f = ((f >> 1) & 0x5555555555555555ULL) | ((f & 0x5555555555555555ULL) << 1);
+    f = ((f >> 2) & 0x3333333333333333ULL) | ((f & 0x3333333333333333ULL) << 2);
+    f = ((f >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((f & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return f >> (8 - n);
+}
+
+ALWAYS_INLINE uint64_t canonicalFixed(uint64_t state, int *stabilizer, const int n) {
+    uint64_t t[8];
+    t[0] = toFrameFixed(state, n);
+    t[1] = frameMirrorFixed(t[0], n);
+    t[2] = __builtin_bswap64(t[0]) >> (8 * (8 - n));
+    t[3] = __builtin_bswap64(t[1]) >> (8 * (8 - n));
+    t[4] = water_frameTranspose(t[0]);
+    t[5] = water_frameTranspose(t[1]);
+    t[6] = water_frameTranspose(t[2]);
+    t[7] = water_frameTranspose(t[3]);
+    return fromFrameFixed(water_minImage(t, stabilizer), n);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FIXED_SIMD_LOOP(LANES, VEC, LOAD, STORE, STEP, DONE, ADD, SET1)               \
+    if (count < LANES) {                                                              \
+        lengthsScalarFixed(states, lengths, count, n);                                \
+        return;                                                                       \
+    }                                                                                 \
+    uint64_t lane[LANES]  __attribute__((aligned(64)));                               \
+    uint64_t steps[LANES] __attribute__((aligned(64)));                               \
+    size_t idx[LANES];                                                                \
+    size_t next = 0;                                                                  \
+    for (int l = 0; l < LANES; l++) {                                                 \
+        lane[l] = states[next];                                                       \
+        steps[l] = 1;                                                                 \
+        idx[l] = next++;                                                              \
+    }                                                                                 \
+    const VEC one = SET1(1);                                                          \
+    unsigned done;                                                                    \
+    do {                                                                              \
+        VEC s0 = LOAD(&lane[0]);                                                      \
+        VEC s1 = LOAD(&lane[LANES / 2]);                                              \
+        VEC c0 = LOAD(&steps[0]);                                                     \
+        VEC c1 = LOAD(&steps[LANES / 2]);                                             \
+        for (;;) {                                                                    \
+            VEC n0 = STEP(s0, n);                                                     \
+            VEC n1 = STEP(s1, n);                                                     \
+            done = DONE(n0, s0) | (DONE(n1, s1) << (LANES / 2));                      \
+            s0 = n0;                                                                  \
+            s1 = n1;                                                                  \
+            if (done)                                                                 \
+                break;                                                                \
+            c0 = ADD(c0, one);                                                        \
+            c1 = ADD(c1, one);                                                        \
+        }                                                                             \
+        STORE(&lane[0], s0);                                                          \
+        STORE(&lane[LANES / 2], s1);                                                  \
+        STORE(&steps[0], c0);                                                         \
+        STORE(&steps[LANES / 2], c1);                                                 \
+    } while (refillLanes(ctx, LANES, done, lane, steps, idx, states, lengths, count, &next));
+
+#define LOAD256(p)      _mm256_load_si256((const __m256i *)(p))
+#define STORE256(p, v)  _mm256_store_si256((__m256i *)(p), v)
+#define DONE256(a, b)   ((unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b))))
+
+__attribute__((target("avx2"), always_inline))
+static inline __m256i stepAvx2Fixed(__m256i s, const int n) {
+    __m256i left  = _mm256_and_si256(_mm256_slli_epi64(s, 1), _mm256_set1_epi64x((long long)FIXED_NOT_FIRST_COL(n)));
+    __m256i right = _mm256_and_si256(_mm256_srli_epi64(s, 1), _mm256_set1_epi64x((long long)FIXED_NOT_LAST_COL(n)));
+    __m256i up    = _mm256_slli_epi64(s, n);
+    __m256i down  = _mm256_srli_epi64(s, n);
+    __m256i two   = _mm256_or_si256(
+        _mm256_or_si256(_mm256_and_si256(left, right), _mm256_and_si256(up, down)),
+        _mm256_and_si256(_mm256_or_si256(left, right), _mm256_or_si256(up, down)));
+    return _mm256_or_si256(s, _mm256_and_si256(two, _mm256_set1_epi64x((long long)FIXED_BOARD_MASK(n))));
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline void lengthsAvx2Fixed(const WaterContext *ctx, const uint64_t *states,
+                                    int *lengths, size_t count, const int n) {
+    FIXED_SIMD_LOOP(8, __m256i, LOAD256, STORE256, stepAvx2Fixed, DONE256,
+                    _mm256_add_epi64, _mm256_set1_epi64x)
+}
+
+__attribute__((target("avx512f"), always_inline))
+static inline __m512i stepAvx512Fixed(__m512i s, const int n) {
+    __m512i left  = _mm512_and_si512(_mm512_slli_epi64(s, 1), _mm512_set1_epi64((long long)FIXED_NOT_FIRST_COL(n)));
+    __m512i right = _mm512_and_si512(_mm512_srli_epi64(s, 1), _mm512_set1_epi64((long long)FIXED_NOT_LAST_COL(n)));
+    __m512i up    = _mm512_slli_epi64(s, n);
+    __m512i down  = _mm512_srli_epi64(s, n);
+    __m512i two = _mm512_ternarylogic_epi64(left, right, _mm512_or_si512(up, down), 0xE8);
+    two = _mm512_or_si512(two, _mm512_and_si512(up, down));
+    return _mm512_ternarylogic_epi64(s, two, _mm512_set1_epi64((long long)FIXED_BOARD_MASK(n)), 0xF8);
+}
+
+#define DONE512(a, b)   ((unsigned)_mm512_cmpeq_epi64_mask(a, b))
+
+__attribute__((target("avx512f"), always_inline))
+static inline void lengthsAvx512Fixed(const WaterContext *ctx, const uint64_t *states,
+                                      int *lengths, size_t count, const int n) {
+    FIXED_SIMD_LOOP(16, __m512i, _mm512_load_si512, _mm512_store_si512, stepAvx512Fixed,
+                    DONE512, _mm512_add_epi64, _mm512_set1_epi64)
+}
+
+#define INSTANTIATE_SIMD_KERNELS(N)                                                               \
+    __attribute__((target("avx2")))                                                               \
+    static void lengthsAvx2_##N(const WaterContext *ctx, const uint64_t *states,                  \
+                                int *lengths, size_t count) {                                     \
+        lengthsAvx2Fixed(ctx, states, lengths, count, N);                                         \
+    }                                                                                             \
+    __attribute__((target("avx512f")))                                                            \
+    static void lengthsAvx512_##N(const WaterContext *ctx, const uint64_t *states,                \
+                                  int *lengths, size_t count) {                                   \
+        lengthsAvx512Fixed(ctx, states, lengths, count, N);                                       \
+    }
+#else
+#define INSTANTIATE_SIMD_KERNELS(N)
+#endif
+
+#define INSTANTIATE_KERNELS(N)                                                                    \
+    static void lengthsScalar_##N(const WaterContext *ctx, const uint64_t *states,                \
+                                  int *lengths, size_t count) {                                   \
+        (void)ctx;                                                                                \
+        lengthsScalarFixed(states, lengths, count, N);                                            \
+    }                                                                                             \
+    static uint64_t canonical_##N(const WaterContext *ctx, uint64_t state, int *stabilizer) {     \
+        (void)ctx;                                                                                \
+        return canonicalFixed(state, stabilizer, N);                                              \
+    }                                                                                             \
+    INSTANTIATE_SIMD_KERNELS(N)
+
+INSTANTIATE_KERNELS(1)
+INSTANTIATE_KERNELS(2)
+INSTANTIATE_KERNELS(3)
+INSTANTIATE_KERNELS(4)
+INSTANTIATE_KERNELS(5)
+INSTANTIATE_KERNELS(6)
+INSTANTIATE_KERNELS(7)
+INSTANTIATE_KERNELS(8)
+
+static const WaterBatchKernel fixedScalarKernels[9] = {
+    NULL, lengthsScalar_1, lengthsScalar_2, lengthsScalar_3, lengthsScalar_4,
+    lengthsScalar_5, lengthsScalar_6, lengthsScalar_7, lengthsScalar_8
+};
+#if defined(__x86_64__) || defined(__i386__)
+static const WaterBatchKernel fixedAvx2Kernels[9] = {
+    NULL, lengthsAvx2_1, lengthsAvx2_2, lengthsAvx2_3, lengthsAvx2_4,
+    lengthsAvx2_5, lengthsAvx2_6, lengthsAvx2_7, lengthsAvx2_8
+};
+static const WaterBatchKernel fixedAvx512Kernels[9] = {
+    NULL, lengthsAvx512_1, lengthsAvx512_2, lengthsAvx512_3, lengthsAvx512_4,
+    lengthsAvx512_5, lengthsAvx512_6, lengthsAvx512_7, lengthsAvx512_8
+};
+#endif
+static const WaterCanonicalKernel fixedCanonicalKernels[9] = {
+    NULL, canonical_1, canonical_2, canonical_3, canonical_4,
+    canonical_5, canonical_6, canonical_7, canonical_8
+};
+
+// ---------------------------------------------------------------------
+// Kernel selection
+// ---------------------------------------------------------------------
+static int cpuHas(WaterIsa isa) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (isa == WATER_AVX512)
+        return __builtin_cpu_supports("avx512f");
+    if (isa == WATER_AVX2)
+        return __builtin_cpu_supports("avx2");
+#endif
+    return isa == WATER_SCALAR;
+}
+
+WaterBatchKernel water_batchKernel(int n, WaterIsa isa, int specialised) {
+    if (n < 1 || n > WATER_MAX_N || !cpuHas(isa))
+        return NULL;
+    switch (isa) {
+#if defined(__x86_64__) || defined(__i386__)
+    case WATER_AVX512:
+        return specialised ? fixedAvx512Kernels[n] : lengthsAvx512;
+    case WATER_AVX2:
+        return specialised ? fixedAvx2Kernels[n] : lengthsAvx2;
+#endif
+    case WATER_SCALAR:
+        return specialised ? fixedScalarKernels[n] : lengthsScalar;
+    default:
+        return NULL;
+    }
+}
+
+WaterCanonicalKernel water_canonicalKernel(int n, int specialised) {
+    if (n < 1 || n > WATER_MAX_N)
+        return NULL;
+    return specialised ? fixedCanonicalKernels[n] : canonicalGeneric;
+}
+
+const char *water_isaName(WaterIsa isa) {
+    switch (isa) {
+    case WATER_AVX512: return "avx512";
+    case WATER_AVX2:   return "avx2";
+    default:           return "scalar";
+    }
+}
+
+const char *water_kernelName(const WaterContext *ctx) {
+    static const char *const names[3][2] = {
+        { "scalar", "scalar (specialised for this n)" },
+        { "avx2",   "avx2 (specialised for this n)" },
+        { "avx512", "avx512 (specialised for this n)" },
+    };
+    return names[ctx->isa][ctx->specialised];
+}
+
+// ---------------------------------------------------------------------
+// Context
+// ---------------------------------------------------------------------
+// Expand/compress stages for frameMask
+// (Hacker's Delight, compress with a constant mask)
+static void buildTransformMasks(WaterContext *ctx) {
+    const int n = ctx->n;
+    ctx->frameMask = 0ULL;
+    for (int y = 0; y < n; y++)
+        for (int x = 0; x < n; x++)
+            ctx->frameMask |= 1ULL << (y * 8 + x);
+    ctx->frameRowShift = 8 * (8 - n);
+    ctx->frameColShift = 8 - n;
+
+    uint64_t m = ctx->frameMask;
+    uint64_t mk = ~m << 1;
+    for (int i = 0; i < 6; i++) {
+        uint64_t mp = mk ^ (mk << 1);
+        mp ^= mp << 2;
+        mp ^= mp << 4;
+        mp ^= mp << 8;
+        mp ^= mp << 16;
+        mp ^= mp << 32;
+        uint64_t mv = mp & m;
+        ctx->frameStage[i] = mv;
+        m = (m ^ mv) | (mv >> (1 << i));
+        mk &= ~mp;
+    }
+}
+
+static void buildNeighborMasks(WaterContext *ctx) {
+    const int n = ctx->n;
+    memset(ctx->neighborMask, 0, sizeof(ctx->neighborMask));
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++) {
+            int c = water_cellIndex(ctx, x, y);
+            if (y > 0)
+                ctx->neighborMask[c] |= (1ULL << water_cellIndex(ctx, x, y - 1));
+            if (y < n - 1)
+                ctx->neighborMask[c] |= (1ULL << water_cellIndex(ctx, x, y + 1));
+            if (x > 0)
+                ctx->neighborMask[c] |= (1ULL << water_cellIndex(ctx, x - 1, y));
+            if (x < n - 1)
+                ctx->neighborMask[c] |= (1ULL << water_cellIndex(ctx, x + 1, y));
+        }
+    }
+
+    // Edge masks for the whole-board step
+    ctx->boardMask = (n == 8) ? ~0ULL : ((1ULL << (n * n)) - 1ULL);
+    ctx->notFirstCol = ctx->boardMask;
+    ctx->notLastCol  = ctx->boardMask;
+    for (int y = 0; y < n; y++) {
+        ctx->notFirstCol &= ~(1ULL << water_cellIndex(ctx, 0, y));
+        ctx->notLastCol  &= ~(1ULL << water_cellIndex(ctx, n - 1, y));
+    }
+}
+
+int water_init(WaterContext *ctx, int n, int flags) {
+    if (n < 1 || n > WATER_MAX_N)
+        return -1;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->n = n;
+    buildNeighborMasks(ctx);
+    buildTransformMasks(ctx);
+    for (int c = 0; c < n * n; c++)
+        water_frameImages(ctx, water_toFrame(ctx, 1ULL << c), ctx->cellImage[c]);
+
+    ctx->specialised = !(flags & WATER_GENERIC);
+    ctx->isa = WATER_SCALAR;
+    if (flags & WATER_SIMD) {
+        if (cpuHas(WATER_AVX512))
+            ctx->isa = WATER_AVX512;
+        else if (cpuHas(WATER_AVX2))
+            ctx->isa = WATER_AVX2;
+    }
+    ctx->lengths = water_batchKernel(n, ctx->isa, ctx->specialised);
+    ctx->canonical = water_canonicalKernel(n, ctx->specialised);
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+// Transforms and printing
+// ---------------------------------------------------------------------
+uint64_t water_transform(const WaterContext *ctx, uint64_t state, int k) {
+    uint64_t t[8];
+    water_frameImages(ctx, water_toFrame(ctx, state), t);
+    return water_fromFrame(ctx, t[k & 7]);
+}
+
+void water_print(const WaterContext *ctx, uint64_t state) {
+    const int n = ctx->n;
+    printf("+");
+    for (int i = 0; i < n * 2 + 1; i++)
+        printf("-");
+    printf("+\n");
+
+    for (int y = 0; y < n; y++) {
+        printf("|");
+        for (int x = 0; x < n; x++) {
+            if (water_isFilled(state, water_cellIndex(ctx, x, y))) {
+                printf(" W");
+            } else {
+                printf(" .");
+            }
+        }
+        printf(" |\n");
+    }
+
+    printf("+");
+    for (int i = 0; i < n * 2 + 1; i++)
+        printf("-");
+    printf("+\n");
+}
@@ -0,0 +1,254 @@
+/*
+  Core kernels for packed boards (n <= 8), shared by every driver.
+
+  A board is one uint64_t, cell (x, y) being bit y * n + x. Everything
+  that depends on n lives in a WaterContext, which water_init() fills in
+  once and nothing writes afterwards. Contexts are independent, so one
+  program can use several, from several threads, with different n.
+
+  The step and the single-board length are static inline functions here,
+  since a call per step would cost more than the step. The batch and
+  canonical kernels are in water.c (libwater.a), and water_init() picks
+  them once: by default the scalar batch kernel and the copies specialised
+  for this n. SIMD is opt-in (WATER_SIMD), since on the boards the
+  enumeration sees it is usually slower (see water.c).
+
+  Build:  make core/libwater.a    (from code-implementations/)
+  Link:   #include "../core/water.h", link ../core/libwater.a
+*/
+
+#ifndef WATER_H
+#define WATER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WATER_MAX_N 8
+#define WATER_BATCH_SIZE 1024
+
+typedef struct WaterContext WaterContext;
+
+// lengths[i] = water_length(ctx, states[i])
+typedef void (*WaterBatchKernel)(const WaterContext *ctx, const uint64_t *states,
+                                 int *lengths, size_t count);
+
+// Smallest of the 8 images; *stabilizer (if not NULL) gets how many of
+// them equal the state (1, 2, 4 or 8), so the orbit has 8 / stabilizer
+// members
+typedef uint64_t (*WaterCanonicalKernel)(const WaterContext *ctx, uint64_t state,
+                                         int *stabilizer);
+
+typedef enum {
+    WATER_SCALAR,
+    WATER_AVX2,
+    WATER_AVX512
+} WaterIsa;
+
+// water_init() flags
+#define WATER_GENERIC 1           // kernels that read n at run time
+#define WATER_SIMD 2              // the widest SIMD batch kernel the CPU has
+
+struct WaterContext {
+    int n;
+    uint64_t boardMask;           // all n*n cells
+    uint64_t notFirstCol;         // cells with x > 0
+    uint64_t notLastCol;          // cells with x < n-1
+    uint64_t neighborMask[64];    // the up to four neighbours of each cell
+
+    // D4 transforms work on an 8x8 frame, cell (x, y) at bit y*8 + x
+    uint64_t frameMask;           // the n x n board inside the frame
+    uint64_t frameStage[6];       // expand/compress masks for frameMask
+    int frameRowShift;            // 8 * (8 - n)
+    int frameColShift;            // 8 - n
+    uint64_t cellImage[64][8];    // frame images of each single cell
+
+    WaterBatchKernel lengths;
+    WaterCanonicalKernel canonical;
+    WaterIsa isa;
+    int specialised;              // kernels are the copies for this n
+};
+
+// Returns 0, or -1 if n is not in 1..WATER_MAX_N
+int water_init(WaterContext *ctx, int n, int flags);
+
+// "avx2 (specialised for this n)" and the like
+const char *water_kernelName(const WaterContext *ctx);
+
+// The kernels water_init() chooses between, for benchmarks and checks;
+// NULL if the CPU or the build does not have the ISA
+WaterBatchKernel water_batchKernel(int n, WaterIsa isa, int specialised);
+WaterCanonicalKernel water_canonicalKernel(int n, int specialised);
+const char *water_isaName(WaterIsa isa);
+
+// Image k of a state, k = 0..7 in the order of water_frameImages()
+uint64_t water_transform(const WaterContext *ctx, uint64_t state, int k);
+
+// The board as a box of 'W' and '.' on stdout
+void water_print(const WaterContext *ctx, uint64_t state);
+
+// ---------------------------------------------------------------------
+// Cells
+// ---------------------------------------------------------------------
+static inline int water_popcount(uint64_t x) {
+    return __builtin_popcountll(x);
+}
+
+static inline int water_cellIndex(const WaterContext *ctx, int x, int y) {
+    return y * ctx->n + x;
+}
+
+static inline int water_isFilled(uint64_t state, int idx) {
+    return (int)((state >> idx) & 1ULL);
+}
+
+static inline void water_fillCell(uint64_t *state, int idx) {
+    *state |= (1ULL << idx);
+}
+
+static inline void water_unfillCell(uint64_t *state, int idx) {
+    *state &= ~(1ULL << idx);
+}
+
+// ---------------------------------------------------------------------
+// Step and length
+//
+// Whole-board step: the four neighbour boards are plain shifts of the
+// state (the column masks stop left/right shifts from wrapping into the
+// next row), and a cell gets water when at least two of them are set.
+// ---------------------------------------------------------------------
+static inline uint64_t water_next(uint64_t s, int n, uint64_t notFirstCol,
+                                  uint64_t notLastCol, uint64_t boardMask) {
+    uint64_t left  = (s << 1) & notFirstCol;   // neighbour at (x-1, y)
+    uint64_t right = (s >> 1) & notLastCol;    // neighbour at (x+1, y)
+    uint64_t up    = s << n;                   // neighbour at (x, y-1)
+    uint64_t down  = s >> n;                   // neighbour at (x, y+1)
+
+    // "at least two of four" as a bit-sliced adder
+    uint64_t atLeastTwo = (left & right) | (up & down)
+                        | ((left | right) & (up | down));
+    return s | (atLeastTwo & boardMask);
+}
+
+// One step; returns 1 if any cell changed
+static inline int water_step(const WaterContext *ctx, uint64_t *state) {
+    uint64_t s = *state;
+    uint64_t next = water_next(s, ctx->n, ctx->notFirstCol, ctx->notLastCol, ctx->boardMask);
+    *state = next;
+    return next != s;
+}
+
+// Number of states until the board stabilizes, the initial one included
+static inline int water_length(const WaterContext *ctx, uint64_t state) {
+    // masks in locals: the loop would otherwise reload them through ctx
+    const int n = ctx->n;
+    const uint64_t nfc = ctx->notFirstCol, nlc = ctx->notLastCol, bm = ctx->boardMask;
+    int steps = 1;
+    for (;;) {
+        uint64_t next = water_next(state, n, nfc, nlc, bm);
+        if (next == state)
+            return steps;
+        state = next;
+        steps++;
+    }
+}
+
+static inline void water_lengths(const WaterContext *ctx, const uint64_t *states,
+                                 int *lengths, size_t count) {
+    ctx->lengths(ctx, states, lengths, count);
+}
+
+// ---------------------------------------------------------------------
+// Symmetry
+//
+// In the 8x8 frame every row is one byte, so the flips are a byte
+// reverse and a bit reverse inside each byte and the diagonal is a
+// delta-swap transpose. For n < 8 a flip leaves the board in the far
+// corner of the frame, so it is shifted back. Moving cells from index
+// y*n+x to y*8+x keeps their order, so comparing frames gives the same
+// answer as comparing packed states.
+// ---------------------------------------------------------------------
+// packed (y*n + x) -> frame (y*8 + x)
+static inline uint64_t water_toFrame(const WaterContext *ctx, uint64_t state) {
+    uint64_t x = state;
+    for (int i = 5; i >= 0; i--) {
+        uint64_t t = x << (1 << i);
+        x = (x & ~ctx->frameStage[i]) | (t & ctx->frameStage[i]);
+    }
+    return x & ctx->frameMask;
+}
+
+// frame (y*8 + x) -> packed (y*n + x)
+static inline uint64_t water_fromFrame(const WaterContext *ctx, uint64_t frame) {
+    uint64_t x = frame & ctx->frameMask;
+    for (int i = 0; i < 6; i++) {
+        uint64_t t = x & ctx->frameStage[i];
+        x = (x ^ t) | (t >> (1 << i));
+    }
+    return x;
+}
+
+// (x,y) -> (x, n-1 - y)
+static inline uint64_t water_frameFlipRows(const WaterContext *ctx, uint64_t f) {
+    return __builtin_bswap64(f) >> ctx->frameRowShift;
+}
+
+// (x,y) -> (n-1 - x, y)
+static inline uint64_t water_frameMirror(const WaterContext *ctx, uint64_t f) {
+    f = ((f >> 1) & 0x5555555555555555ULL) | ((f & 0x5555555555555555ULL) << 1);
+    f = ((f >> 2) & 0x3333333333333333ULL) | ((f & 0x3333333333333333ULL) << 2);
+    f = ((f >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((f & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return f >> ctx->frameColShift;
+}
+
+// (x,y) -> (y,x)
+static inline uint64_t water_frameTranspose(uint64_t f) {
+    uint64_t t;
+    t  = 0x0F0F0F0F00000000ULL & (f ^ (f << 28));
+    f ^= t ^ (t >> 28);
+    t  = 0x3333000033330000ULL & (f ^ (f << 14));
+    f ^= t ^ (t >> 14);
+    t  = 0x5500550055005500ULL & (f ^ (f <<  7));
+    f ^= t ^ (t >>  7);
+    return f;
+}
+
+// All 8 images of a frame: bit 0 of the index mirrors, bit 1 flips the
+// rows, bit 2 transposes after the other two
+static inline void water_frameImages(const WaterContext *ctx, uint64_t frame, uint64_t t[8]) {
+    t[0] = frame;                           // identity
+    t[1] = water_frameMirror(ctx, t[0]);
+    t[2] = water_frameFlipRows(ctx, t[0]);
+    t[3] = water_frameFlipRows(ctx, t[1]);  // rotate 180
+    t[4] = water_frameTranspose(t[0]);
+    t[5] = water_frameTranspose(t[1]);
+    t[6] = water_frameTranspose(t[2]);
+    t[7] = water_frameTranspose(t[3]);
+}
+
+// Smallest image, plus how many images equal t[0]
+static inline uint64_t water_minImage(const uint64_t t[8], int *stabilizer) {
+    uint64_t best = t[0];
+    int same = 1;
+    for (int i = 1; i < 8; i++) {
+        if (t[i] < best)
+            best = t[i];
+        same += (t[i] == t[0]);
+    }
+    if (stabilizer)
+        *stabilizer = same;
+    return best;
+}
+
+static inline uint64_t water_canonical(const WaterContext *ctx, uint64_t state, int *stabilizer) {
+    return ctx->canonical(ctx, state, stabilizer);
+}
+
+// Every transform is linear over GF(2), so flipping cell c of a state
+// flips the images by the images of that cell. Enumerating in Gray-code
+// order keeps all eight images up to date with one XOR each.
+static inline void water_grayFlip(const WaterContext *ctx, uint64_t t[8], int c) {
+    for (int i = 0; i < 8; i++)
+        t[i] ^= ctx->cellImage[c][i];
+}
+
+#endif
@@ -0,0 +1,330 @@
+/*
+  Row-array boards for grids larger than 8x8.
+
+  A WideBoard keeps one uint32_t per row, bit x of row[y] being the cell
+  (x, y). This is the same cell order as the single-uint64_t boards used for
+  n <= 8 (cell index y * n + x), so comparing two WideBoards row by row from
+  the last row down gives the same order as comparing the packed numbers,
+  and canonical representatives agree between the two layouts.
+
+  Everything is a static inline function so a driver only has to include
+  this header.
+*/
+
+#ifndef WIDE_BOARD_H
+#define WIDE_BOARD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define WB_MAX_N 32
+
+typedef struct {
+    uint32_t row[WB_MAX_N];
+} WideBoard;
+
+static inline uint32_t wb_rowMask(int n) {
+    return (n == 32) ? 0xFFFFFFFFu : ((1u << n) - 1u);
+}
+
+static inline void wb_clear(WideBoard *b) {
+    memset(b, 0, sizeof(*b));
+}
+
+static inline int wb_isFilled(const WideBoard *b, int x, int y) {
+    return (b->row[y] >> x) & 1u;
+}
+
+static inline void wb_fillCell(WideBoard *b, int x, int y) {
+    b->row[y] |= (1u << x);
+}
+
+static inline void wb_unfillCell(WideBoard *b, int x, int y) {
+    b->row[y] &= ~(1u << x);
+}
+
+static inline int wb_equal(const WideBoard *a, const WideBoard *b, int n) {
+    return memcmp(a->row, b->row, sizeof(uint32_t) * (size_t)n) == 0;
+}
+
+// Same order as the packed uint64_t value: the last row is most significant
+static inline int wb_compare(const WideBoard *a, const WideBoard *b, int n) {
+    for (int y = n - 1; y >= 0; y--) {
+        if (a->row[y] != b->row[y])
+            return (a->row[y] < b->row[y]) ? -1 : 1;
+    }
+    return 0;
+}
+
+static inline int wb_popcount(const WideBoard *b, int n) {
+    int count = 0;
+    for (int y = 0; y < n; y++)
+        count += __builtin_popcount(b->row[y]);
+    return count;
+}
+
+// Conversions to and from the packed layout (n <= 8 only)
+static inline WideBoard wb_fromPacked(uint64_t state, int n) {
+    WideBoard b;
+    wb_clear(&b);
+    for (int y = 0; y < n; y++)
+        b.row[y] = (uint32_t)(state >> (y * n)) & wb_rowMask(n);
+    return b;
+}
+
+static inline uint64_t wb_toPacked(const WideBoard *b, int n) {
+    uint64_t state = 0ULL;
+    for (int y = 0; y < n; y++)
+        state |= (uint64_t)b->row[y] << (y * n);
+    return state;
+}
+
+// One iteration step; returns 1 if any cell changed.
+// Each row is updated with word operations: left/right neighbours are the
+// row shifted by one, up/down neighbours are the old values of the rows
+// around it.
+static inline int wb_step(WideBoard *b, int n) {
+    const uint32_t mask = wb_rowMask(n);
+    uint32_t prev = 0u;          // old value of row y-1
+    uint32_t diff = 0u;
+    for (int y = 0; y < n; y++) {
+        uint32_t cur   = b->row[y];
+        uint32_t down  = (y + 1 < n) ? b->row[y + 1] : 0u;
+        uint32_t left  = (cur << 1) & mask;   // neighbour at (x-1, y)
+        uint32_t right = cur >> 1;            // neighbour at (x+1, y)
+        uint32_t up    = prev;
+        uint32_t two   = (left & right) | (up & down)
+                       | ((left | right) & (up | down));
+        uint32_t next  = cur | (two & mask);
+        diff |= next ^ cur;
+        b->row[y] = next;
+        prev = cur;
+    }
+    return diff != 0u;
+}
+
+// Compute steps until the grid stabilizes
+static inline int wb_compute_length(WideBoard b, int n) {
+    int steps = 1;
+    while (wb_step(&b, n)) {
+        steps++;
+    }
+    return steps;
+}
+
+// ------------------------------
+// Frontier (event-driven) stepping
+//
+// An empty cell can only fill at a step if one of its neighbours filled at
+// the step before: otherwise it had the same neighbours one step earlier
+// and stayed empty then. So a step only looks at the empty neighbours of
+// the cells that just filled ('fresh'), in the rows next to them. Late in a
+// long, snake-like evolution the front is a handful of cells, and a step
+// costs a few rows instead of n.
+// ------------------------------
+typedef struct {
+    uint32_t fresh[WB_MAX_N];   // cells filled by the last step (0 elsewhere)
+    uint32_t freshRows;         // bit y set if fresh[y] != 0
+} WbFrontier;
+
+// Start of an evolution: every filled cell counts as fresh
+static inline void wb_frontierInit(WbFrontier *f, const WideBoard *b, int n) {
+    memset(f, 0, sizeof(*f));
+    for (int y = 0; y < n; y++) {
+        f->fresh[y] = b->row[y];
+        if (b->row[y])
+            f->freshRows |= 1u << y;
+    }
+}
+
+// Resume an evolution whose last step went from 'before' to 'after'
+static inline void wb_frontierFrom(WbFrontier *f, const WideBoard *before,
+                                   const WideBoard *after, int n) {
+    memset(f, 0, sizeof(*f));
+    for (int y = 0; y < n; y++) {
+        f->fresh[y] = after->row[y] & ~before->row[y];
+        if (f->fresh[y])
+            f->freshRows |= 1u << y;
+    }
+}
+
+// Same result as wb_step; returns 1 if any cell changed
+static inline int wb_stepFrontier(WideBoard *b, WbFrontier *f, int n) {
+    const uint32_t mask = wb_rowMask(n);
+    // Row numbers are n bits as well, so the same mask keeps them on the board
+    uint32_t rows = (f->freshRows | (f->freshRows << 1) | (f->freshRows >> 1)) & mask;
+    uint32_t filled[WB_MAX_N];
+    uint32_t filledRows = 0u;
+
+    // Decide every row from the old state before changing any of them
+    for (uint32_t r = rows; r != 0u; r &= r - 1u) {
+        int y = __builtin_ctz(r);
+        uint32_t cur  = b->row[y];
+        uint32_t near = (f->fresh[y] << 1) | (f->fresh[y] >> 1)
+                      | ((y > 0) ? f->fresh[y - 1] : 0u)
+                      | ((y + 1 < n) ? f->fresh[y + 1] : 0u);
+        uint32_t candidates = near & ~cur & mask;
+        if (candidates == 0u)
+            continue;
+
+        uint32_t left  = (cur << 1) & mask;
+        uint32_t right = cur >> 1;
+        uint32_t up    = (y > 0) ? b->row[y - 1] : 0u;
+        uint32_t down  = (y + 1 < n) ? b->row[y + 1] : 0u;
+        uint32_t two   = (left & right) | (up & down)
+                       | ((left | right) & (up | down));
+        if (two & candidates) {
+            filled[y] = two & candidates;
+            filledRows |= 1u << y;
+        }
+    }
+
+    for (uint32_t r = f->freshRows; r != 0u; r &= r - 1u)
+        f->fresh[__builtin_ctz(r)] = 0u;
+    for (uint32_t r = filledRows; r != 0u; r &= r - 1u) {
+        int y = __builtin_ctz(r);
+        b->row[y] |= filled[y];
+        f->fresh[y] = filled[y];
+    }
+    f->freshRows = filledRows;
+    return filledRows != 0u;
+}
+
+// wb_step that also records the cells it filled in f
+static inline int wb_stepTracked(WideBoard *b, WbFrontier *f, int n) {
+    const uint32_t mask = wb_rowMask(n);
+    uint32_t prev = 0u;          // old value of row y-1
+    uint32_t changedRows = 0u;
+    for (int y = 0; y < n; y++) {
+        uint32_t cur   = b->row[y];
+        uint32_t down  = (y + 1 < n) ? b->row[y + 1] : 0u;
+        uint32_t left  = (cur << 1) & mask;
+        uint32_t right = cur >> 1;
+        uint32_t up    = prev;
+        uint32_t two   = (left & right) | (up & down)
+                       | ((left | right) & (up | down));
+        uint32_t next  = cur | (two & mask);
+        f->fresh[y] = next ^ cur;
+        if (next != cur)
+            changedRows |= 1u << y;
+        b->row[y] = next;
+        prev = cur;
+    }
+    f->freshRows = changedRows;
+    return changedRows != 0u;
+}
+
+// A frontier step looks at about three rows per fresh row and does more
+// work per row than wb_step, so it only pays once the front is narrow.
+// Early steps (and short evolutions) take the full pass.
+static inline int wb_stepAdaptive(WideBoard *b, WbFrontier *f, int n) {
+    if (3 * __builtin_popcount(f->freshRows) >= n)
+        return wb_stepTracked(b, f, n);
+    return wb_stepFrontier(b, f, n);
+}
+
+static inline int wb_compute_length_frontier(WideBoard b, int n) {
+    WbFrontier f;
+    wb_frontierInit(&f, &b, n);
+    int steps = 1;
+    while (wb_stepAdaptive(&b, &f, n)) {
+        steps++;
+    }
+    return steps;
+}
+
+// ------------------------------
+// D4 transforms
+//
+// flipRows (top <-> bottom) reverses the row order, mirror (left <-> right)
+// bit-reverses each row, and transpose is a 32x32 bit-matrix transpose by
+// delta swaps. The other five symmetries are compositions of these.
+// ------------------------------
+static inline uint32_t wb_reverse32(uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    return __builtin_bswap32(x);
+}
+
+static inline WideBoard wb_flipRows(const WideBoard *b, int n) {
+    WideBoard out;
+    wb_clear(&out);
+    for (int y = 0; y < n; y++)
+        out.row[y] = b->row[n - 1 - y];
+    return out;
+}
+
+static inline WideBoard wb_mirror(const WideBoard *b, int n) {
+    WideBoard out;
+    wb_clear(&out);
+    for (int y = 0; y < n; y++)
+        out.row[y] = wb_reverse32(b->row[y]) >> (32 - n);
+    return out;
+}
+
+// (x, y) -> (y, x)
+static inline WideBoard wb_transpose(const WideBoard *b, int n) {
+    uint32_t a[32];
+    memset(a, 0, sizeof(a));
+    memcpy(a, b->row, sizeof(uint32_t) * (size_t)n);
+
+    uint32_t m = 0x0000FFFFu;
+    for (int j = 16; j != 0; j >>= 1, m ^= (m << j)) {
+        for (int k = 0; k < 32; k = (k + j + 1) & ~j) {
+            uint32_t t = ((a[k] >> j) ^ a[k + j]) & m;
+            a[k + j] ^= t;
+            a[k]     ^= t << j;
+        }
+    }
+
+    WideBoard out;
+    wb_clear(&out);
+    memcpy(out.row, a, sizeof(uint32_t) * (size_t)n);
+    return out;
+}
+
+// Canonical representative (minimum over the 8 symmetric images).
+// Returns the stabilizer size, i.e. how many of the 8 images equal the board.
+static inline int wb_canonical(const WideBoard *b, int n, WideBoard *out) {
+    WideBoard t[8];
+    t[0] = *b;
+    t[1] = wb_mirror(b, n);
+    t[2] = wb_flipRows(b, n);
+    t[3] = wb_flipRows(&t[1], n);
+    for (int i = 0; i < 4; i++)
+        t[4 + i] = wb_transpose(&t[i], n);
+
+    int best = 0;
+    int stabilizer = 0;
+    for (int i = 0; i < 8; i++) {
+        if (i > 0 && wb_compare(&t[i], &t[best], n) < 0)
+            best = i;
+        if (wb_equal(&t[i], b, n))
+            stabilizer++;
+    }
+    *out = t[best];
+    return stabilizer;
+}
+
+static inline void wb_print(const WideBoard *b, int n) {
+    printf("+");
+    for (int i = 0; i < n * 2 + 1; i++)
+        printf("-");
+    printf("+\n");
+
+    for (int y = 0; y < n; y++) {
+        printf("|");
+        for (int x = 0; x < n; x++)
+            printf(wb_isFilled(b, x, y) ? " W" : " .");
+        printf(" |\n");
+    }
+
+    printf("+");
+    for (int i = 0; i < n * 2 + 1; i++)
+        printf("-");
+    printf("+\n");
+}
+
+#endif
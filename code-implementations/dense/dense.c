@@ -0,0 +1,613 @@
+/*
+  Dense simulator for large boards (n up to 65536), with generators for the
+  long-lasting constructions, to measure length/n^2 at scale.
+
+  The board is an array of rows, each row ceil(n/64) words plus a zero word
+  on either side, and there is a zero row above and below. A step works
+  word by word: left and right neighbours are the row shifted by one bit
+  with the carry taken from the adjacent word, up and down are the same
+  word of the adjacent rows, and a cell fills when at least two of the
+  four are filled. No masking is needed at the edges: a bit past the board
+  only ever sees one filled neighbour, so it never fills.
+
+  Only rows that can change are visited. A row can change in a step only
+  if it or a neighbouring row changed in the step before, and then only in
+  the words next to the ones that changed, so each step works on the rows
+  around the previous step's changes, over the changed words widened by
+  one. A front crossing the board (the snake below) costs a few words per
+  step, not n*n/64.
+
+  Threads: when a step touches at least --parallel-words words, the rows
+  to visit are split into contiguous bands of equal work, one per thread.
+  A band is updated in place with each new row written one row late, once
+  the row below it has been computed. The first and last rows of a band
+  are held back until every thread has finished computing, because the
+  neighbouring bands read them as halo rows. The extra memory is three
+  rows per thread.
+
+  Patterns:
+    - diagonal: the diagonal of Theorem T3 (length n)
+    - snake:    row 0 full, and one cell on every other row from row 2,
+                alternately at the left and the right edge. The front runs
+                along row 1, turns, runs back along row 3, and so on,
+                for length about n^2/2 (n(n-1)/2 when 4 divides n)
+    - random:   cells filled independently with probability --density
+    - --file:   rows of text, 'W', '#', 'x' or '1' is a filled cell
+
+  Usage: dense [--pattern diagonal|snake|random] [--density P] [--seed S]
+               [--file PATH] [--threads N] [--parallel-words W] [--check]
+         dense --sweep N_MIN N_MAX STEP [--pattern ...]
+         dense --self-check
+  A single run reads n from stdin; --check compares with the WideBoard
+  step for n <= 32. --sweep prints "n length length/n^2" lines for
+  plotting against 13/18. --self-check runs at least two threads so the
+  banded step is exercised.
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "../core/wide_board.h"
+
+// ---------------------------------------------------------------------
+// Global variables
+// ---------------------------------------------------------------------
+static int g_n = 0;               // Board size, read from user
+#define MAX_N 65536
+#define MAX_THREADS 256
+
+static int g_words = 0;           // words per row
+static size_t g_stride = 0;       // g_words plus the two padding words
+static uint64_t* g_grid = NULL;   // n + 2 rows of g_stride words
+
+static inline uint64_t* row(int y) {
+    return g_grid + ((size_t)y + 1) * g_stride + 1;
+}
+
+// Rows to visit this step, in increasing order, with their word spans
+static int* g_rows = NULL;
+static int* g_from = NULL;
+static int* g_to = NULL;
+static int g_rowCount = 0;
+static int* g_slot = NULL;        // index into g_rows, or -1
+
+// Words that changed in the last step, per row (g_lo > g_hi: none)
+static int* g_lo = NULL;
+static int* g_hi = NULL;
+static int* g_changed = NULL;     // rows that changed, in increasing order
+static int g_changedCount = 0;
+
+static int g_threadCount = 1;
+static long long g_parallelWords = 1 << 14;
+
+// ---------------------------------------------------------------------
+// Row kernels: out[i - a] = row y after one step, for words a..b
+// ---------------------------------------------------------------------
+typedef void (*RowKernel)(const uint64_t* up, const uint64_t* cur, const uint64_t* down,
+                          uint64_t* out, int a, int b);
+
+static void stepRowScalar(const uint64_t* up, const uint64_t* cur, const uint64_t* down,
+                          uint64_t* out, int a, int b) {
+    for (int i = a; i <= b; i++) {
+        uint64_t left  = (cur[i] << 1) | (cur[i - 1] >> 63);
+        uint64_t right = (cur[i] >> 1) | (cur[i + 1] << 63);
+        uint64_t two = (left & right) | (up[i] & down[i]) | ((left | right) & (up[i] | down[i]));
+        out[i - a] = cur[i] | two;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+__attribute__((target("avx2")))
+static void stepRowAvx2(const uint64_t* up, const uint64_t* cur, const uint64_t* down,
+                        uint64_t* out, int a, int b) {
+    int i = a;
+    for (; i + 3 <= b; i += 4) {
+        __m256i c  = _mm256_loadu_si256((const __m256i*)&cur[i]);
+        __m256i cl = _mm256_loadu_si256((const __m256i*)&cur[i - 1]);
+        __m256i cr = _mm256_loadu_si256((const __m256i*)&cur[i + 1]);
+        __m256i u  = _mm256_loadu_si256((const __m256i*)&up[i]);
+        __m256i d  = _mm256_loadu_si256((const __m256i*)&down[i]);
+        __m256i left  = _mm256_or_si256(_mm256_slli_epi64(c, 1), _mm256_srli_epi64(cl, 63));
+        __m256i right = _mm256_or_si256(_mm256_srli_epi64(c, 1), _mm256_slli_epi64(cr, 63));
+        __m256i two = _mm256_or_si256(
+            _mm256_or_si256(_mm256_and_si256(left, right), _mm256_and_si256(u, d)),
+            _mm256_and_si256(_mm256_or_si256(left, right), _mm256_or_si256(u, d)));
+        _mm256_storeu_si256((__m256i*)&out[i - a], _mm256_or_si256(c, two));
+    }
+    if (i <= b)
+        stepRowScalar(up, cur, down, out + (i - a), i, b);
+}
+#endif
+
+static RowKernel g_stepRow = stepRowScalar;
+static const char* g_stepRowName = "scalar";
+
+static void selectRowKernel(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        g_stepRow = stepRowAvx2;
+        g_stepRowName = "avx2";
+    }
+#endif
+}
+
+// ---------------------------------------------------------------------
+// Board allocation and patterns
+// ---------------------------------------------------------------------
+static void freeBoard(void) {
+    free(g_grid);
+    free(g_rows);
+    free(g_from);
+    free(g_to);
+    free(g_slot);
+    free(g_lo);
+    free(g_hi);
+    free(g_changed);
+    g_grid = NULL;
+    g_rows = g_from = g_to = g_slot = g_lo = g_hi = g_changed = NULL;
+}
+
+static int allocBoard(void) {
+    freeBoard();
+    g_words = (g_n + 63) / 64;
+    g_stride = (size_t)g_words + 2;
+    g_grid = (uint64_t*)calloc(((size_t)g_n + 2) * g_stride, sizeof(uint64_t));
+    g_rows = (int*)malloc(sizeof(int) * (size_t)g_n);
+    g_from = (int*)malloc(sizeof(int) * (size_t)g_n);
+    g_to = (int*)malloc(sizeof(int) * (size_t)g_n);
+    g_slot = (int*)malloc(sizeof(int) * (size_t)g_n);
+    g_lo = (int*)malloc(sizeof(int) * (size_t)g_n);
+    g_hi = (int*)malloc(sizeof(int) * (size_t)g_n);
+    g_changed = (int*)malloc(sizeof(int) * (size_t)g_n);
+    if (!g_grid || !g_rows || !g_from || !g_to || !g_slot || !g_lo || !g_hi || !g_changed) {
+        printf("Out of memory for n = %d\n", g_n);
+        return 0;
+    }
+    for (int y = 0; y < g_n; y++)
+        g_slot[y] = -1;
+    return 1;
+}
+
+static inline void setCell(int x, int y) {
+    row(y)[x >> 6] |= 1ULL << (x & 63);
+}
+
+static inline int cellFilled(int x, int y) {
+    return (int)((row(y)[x >> 6] >> (x & 63)) & 1ULL);
+}
+
+static uint64_t xorshift64(uint64_t* s) {
+    uint64_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *s = x;
+}
+
+static int fillPattern(const char* pattern, double density, uint64_t seed) {
+    if (strcmp(pattern, "diagonal") == 0) {
+        for (int i = 0; i < g_n; i++)
+            setCell(i, i);
+    } else if (strcmp(pattern, "snake") == 0) {
+        for (int x = 0; x < g_n; x++)
+            setCell(x, 0);
+        for (int y = 2, side = 0; y < g_n; y += 2, side ^= 1)
+            setCell(side ? g_n - 1 : 0, y);
+    } else if (strcmp(pattern, "random") == 0) {
+        uint64_t rng = seed ? seed : 0x9E3779B97F4A7C15ULL;
+        uint64_t threshold = (uint64_t)(density * 18446744073709551615.0);
+        for (int y = 0; y < g_n; y++) {
+            for (int x = 0; x < g_n; x++) {
+                if (xorshift64(&rng) < threshold)
+                    setCell(x, y);
+            }
+        }
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+static int readPatternFile(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f)
+        return 0;
+    static char line[MAX_N + 2];
+    for (int y = 0; y < g_n && fgets(line, sizeof(line), f); y++) {
+        for (int x = 0; x < g_n && line[x] && line[x] != '\n'; x++) {
+            char ch = line[x];
+            if (ch == 'W' || ch == '#' || ch == 'x' || ch == '1')
+                setCell(x, y);
+        }
+    }
+    fclose(f);
+    return 1;
+}
+
+// ---------------------------------------------------------------------
+// One step over the rows in g_rows
+// ---------------------------------------------------------------------
+typedef struct {
+    int begin, end;               // range of g_rows
+    uint64_t* buf[3];             // pending rows: previous, first, scratch
+} Band;
+
+static Band g_bands[MAX_THREADS];
+
+// Write a computed row back and record which of its words changed
+static void commitRow(int slot, const uint64_t* computed) {
+    int y = g_rows[slot], a = g_from[slot], b = g_to[slot];
+    uint64_t* r = row(y);
+    int lo = INT_MAX, hi = -1;
+    for (int i = a; i <= b; i++) {
+        if (computed[i - a] != r[i]) {
+            r[i] = computed[i - a];
+            if (lo == INT_MAX)
+                lo = i;
+            hi = i;
+        }
+    }
+    g_lo[y] = lo;
+    g_hi[y] = hi;
+}
+
+static inline void swapBuf(uint64_t** a, uint64_t** b) {
+    uint64_t* t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// Compute a band in place, one row late; leaves its first and last rows
+// pending, since the neighbouring bands read them
+static void computeBand(Band* band) {
+    uint64_t** prev = &band->buf[0];
+    uint64_t** first = &band->buf[1];
+    uint64_t** scratch = &band->buf[2];
+    for (int s = band->begin; s < band->end; s++) {
+        int y = g_rows[s];
+        g_stepRow(row(y - 1), row(y), row(y + 1), *scratch, g_from[s], g_to[s]);
+        if (s == band->begin) {
+            swapBuf(first, scratch);
+            continue;
+        }
+        // row s-1 is no longer needed by anything but the neighbour bands
+        if (s - 1 != band->begin)
+            commitRow(s - 1, *prev);
+        swapBuf(prev, scratch);
+    }
+}
+
+static void finishBand(Band* band) {
+    if (band->end <= band->begin)
+        return;
+    commitRow(band->begin, band->buf[1]);
+    if (band->end - 1 != band->begin)
+        commitRow(band->end - 1, band->buf[0]);
+}
+
+// Workers wait at the barrier until the main thread starts a parallel step
+static pthread_barrier_t g_barrier;
+static volatile int g_quit = 0;
+
+static void* workerThread(void* arg) {
+    Band* band = (Band*)arg;
+    for (;;) {
+        pthread_barrier_wait(&g_barrier);
+        if (g_quit)
+            break;
+        computeBand(band);
+        pthread_barrier_wait(&g_barrier);
+        finishBand(band);
+        pthread_barrier_wait(&g_barrier);
+    }
+    return NULL;
+}
+
+// Rows to visit: every row next to a change, over the changed words
+// widened by one word
+static void collectRows(void) {
+    g_rowCount = 0;
+    for (int c = 0; c < g_changedCount; c++) {
+        int r = g_changed[c];
+        int a = g_lo[r] > 0 ? g_lo[r] - 1 : 0;
+        int b = g_hi[r] < g_words - 1 ? g_hi[r] + 1 : g_words - 1;
+        for (int y = r - 1; y <= r + 1; y++) {
+            if (y < 0 || y >= g_n)
+                continue;
+            int s = g_slot[y];
+            if (s < 0) {
+                s = g_rowCount++;
+                g_slot[y] = s;
+                g_rows[s] = y;
+                g_from[s] = a;
+                g_to[s] = b;
+            } else {
+                if (a < g_from[s]) g_from[s] = a;
+                if (b > g_to[s]) g_to[s] = b;
+            }
+        }
+    }
+}
+
+// Returns 1 if any cell filled
+static int step(void) {
+    collectRows();
+    long long work = 0;
+    for (int s = 0; s < g_rowCount; s++)
+        work += g_to[s] - g_from[s] + 1;
+
+    if (g_threadCount > 1 && work >= g_parallelWords) {
+        // bands of about equal work
+        long long done = 0;
+        int s = 0;
+        for (int t = 0; t < g_threadCount; t++) {
+            g_bands[t].begin = s;
+            long long target = work * (t + 1) / g_threadCount;
+            while (s < g_rowCount && done < target) {
+                done += g_to[s] - g_from[s] + 1;
+                s++;
+            }
+            g_bands[t].end = s;
+        }
+        pthread_barrier_wait(&g_barrier);
+        computeBand(&g_bands[0]);
+        pthread_barrier_wait(&g_barrier);
+        finishBand(&g_bands[0]);
+        pthread_barrier_wait(&g_barrier);
+    } else {
+        g_bands[0].begin = 0;
+        g_bands[0].end = g_rowCount;
+        computeBand(&g_bands[0]);
+        finishBand(&g_bands[0]);
+    }
+
+    g_changedCount = 0;
+    for (int s = 0; s < g_rowCount; s++) {
+        int y = g_rows[s];
+        g_slot[y] = -1;
+        if (g_lo[y] <= g_hi[y])
+            g_changed[g_changedCount++] = y;
+    }
+    return g_changedCount > 0;
+}
+
+// Number of states including the initial one, as compute_length counts
+static uint64_t denseLength(void) {
+    // first step: every row, every word
+    g_changedCount = 0;
+    for (int y = 0; y < g_n; y++) {
+        g_changed[g_changedCount++] = y;
+        g_lo[y] = 0;
+        g_hi[y] = g_words - 1;
+    }
+    uint64_t length = 1;
+    while (step())
+        length++;
+    return length;
+}
+
+// ---------------------------------------------------------------------
+// Threads
+// ---------------------------------------------------------------------
+static pthread_t g_workers[MAX_THREADS];
+
+static void startThreads(void) {
+    for (int t = 0; t < g_threadCount; t++) {
+        for (int i = 0; i < 3; i++)
+            g_bands[t].buf[i] = (uint64_t*)malloc(sizeof(uint64_t) * (MAX_N / 64));
+    }
+    if (g_threadCount > 1) {
+        pthread_barrier_init(&g_barrier, NULL, (unsigned)g_threadCount);
+        for (int t = 1; t < g_threadCount; t++)
+            pthread_create(&g_workers[t], NULL, workerThread, &g_bands[t]);
+    }
+}
+
+static void stopThreads(void) {
+    if (g_threadCount > 1) {
+        g_quit = 1;
+        pthread_barrier_wait(&g_barrier);
+        for (int t = 1; t < g_threadCount; t++)
+            pthread_join(g_workers[t], NULL);
+        pthread_barrier_destroy(&g_barrier);
+    }
+    for (int t = 0; t < g_threadCount; t++) {
+        for (int i = 0; i < 3; i++)
+            free(g_bands[t].buf[i]);
+    }
+}
+
+// ---------------------------------------------------------------------
+// Checks against the WideBoard step
+// ---------------------------------------------------------------------
+static WideBoard toWideBoard(void) {
+    WideBoard b;
+    wb_clear(&b);
+    for (int y = 0; y < g_n; y++) {
+        for (int x = 0; x < g_n; x++) {
+            if (cellFilled(x, y))
+                wb_fillCell(&b, x, y);
+        }
+    }
+    return b;
+}
+
+static int runSelfCheck(void) {
+    uint64_t rng = 0x123456789ABCDEFULL;
+    // every step in parallel bands, even the small ones
+    g_parallelWords = 0;
+    for (g_n = 1; g_n <= WB_MAX_N; g_n++) {
+        for (int i = 0; i < 64; i++) {
+            if (!allocBoard())
+                return 1;
+            const char* pattern = (i == 0) ? "snake" : (i == 1) ? "diagonal" : "random";
+            double density = 0.02 + 0.2 * (double)(xorshift64(&rng) % 1000) / 1000.0;
+            fillPattern(pattern, density, xorshift64(&rng));
+            int expected = wb_compute_length(toWideBoard(), g_n);
+            uint64_t got = denseLength();
+            if (got != (uint64_t)expected) {
+                printf("Dense length %llu != %d for n = %d (%s)\n",
+                       (unsigned long long)got, expected, g_n, pattern);
+                return 1;
+            }
+        }
+    }
+    // rows of several words: the snake's known length, and random boards
+    // stepped in bands against the single-thread result
+    for (g_n = 60; g_n <= 300; g_n += 12) {
+        if (!allocBoard())
+            return 1;
+        fillPattern("snake", 0.0, 0);
+        uint64_t got = denseLength();
+        if (got != (uint64_t)g_n * (uint64_t)(g_n - 1) / 2) {
+            printf("Snake length %llu for n = %d\n", (unsigned long long)got, g_n);
+            return 1;
+        }
+        uint64_t seed = xorshift64(&rng);
+        allocBoard();
+        fillPattern("random", 0.03, seed);
+        uint64_t banded = denseLength();
+        int threads = g_threadCount;
+        g_threadCount = 1;
+        allocBoard();
+        fillPattern("random", 0.03, seed);
+        uint64_t single = denseLength();
+        g_threadCount = threads;
+        if (banded != single) {
+            printf("Banded length %llu != %llu for n = %d\n",
+                   (unsigned long long)banded, (unsigned long long)single, g_n);
+            return 1;
+        }
+    }
+    printf("Self-check passed (%d threads, %s rows)\n", g_threadCount, g_stepRowName);
+    return 0;
+}
+
+static double secondsSince(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + 1e-9 * (double)(now.tv_nsec - start->tv_nsec);
+}
+
+// ---------------------------------------------------------------------
+// main()
+// ---------------------------------------------------------------------
+int main(int argc, char **argv) {
+    const char* pattern = "snake";
+    const char* file = NULL;
+    double density = 0.1;
+    uint64_t seed = 0;
+    int check = 0, selfCheck = 0;
+    int sweepMin = 0, sweepMax = 0, sweepStep = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--self-check") == 0) {
+            selfCheck = 1;
+        } else if (strcmp(argv[a], "--pattern") == 0 && a + 1 < argc) {
+            pattern = argv[++a];
+        } else if (strcmp(argv[a], "--density") == 0 && a + 1 < argc) {
+            density = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) {
+            seed = strtoull(argv[++a], NULL, 10);
+        } else if (strcmp(argv[a], "--file") == 0 && a + 1 < argc) {
+            file = argv[++a];
+        } else if ((strcmp(argv[a], "--threads") == 0 || strcmp(argv[a], "-t") == 0) && a + 1 < argc) {
+            g_threadCount = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--parallel-words") == 0 && a + 1 < argc) {
+            g_parallelWords = atoll(argv[++a]);
+        } else if (strcmp(argv[a], "--check") == 0) {
+            check = 1;
+        } else if (strcmp(argv[a], "--sweep") == 0 && a + 3 < argc) {
+            sweepMin = atoi(argv[++a]);
+            sweepMax = atoi(argv[++a]);
+            sweepStep = atoi(argv[++a]);
+        } else {
+            printf("Usage: %s [--pattern diagonal|snake|random] [--density P] [--seed S]\n"
+                   "       [--file PATH] [--threads N] [--parallel-words W] [--check]\n"
+                   "       %s --sweep N_MIN N_MAX STEP [--pattern ...]\n"
+                   "       %s --self-check\n", argv[0], argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (g_threadCount < 1 || g_threadCount > MAX_THREADS) {
+        printf("--threads must be between 1 and %d\n", MAX_THREADS);
+        return 1;
+    }
+    // the self-check compares banded steps with single-thread ones, and
+    // step() only splits into bands with two threads or more
+    if (selfCheck && g_threadCount < 2)
+        g_threadCount = 2;
+    selectRowKernel();
+    startThreads();
+
+    int status = 0;
+    if (selfCheck) {
+        status = runSelfCheck();
+    } else if (sweepStep > 0) {
+        if (sweepMin < 1 || sweepMax > MAX_N) {
+            printf("The sweep must stay within 1..%d\n", MAX_N);
+            status = 1;
+        }
+        printf("# %s, 13/18 = %.6f\n# n length length/n^2 seconds\n", pattern, 13.0 / 18.0);
+        for (g_n = sweepMin; !status && g_n <= sweepMax; g_n += sweepStep) {
+            if (!allocBoard() || !fillPattern(pattern, density, seed)) {
+                status = 1;
+                break;
+            }
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            uint64_t length = denseLength();
+            printf("%d %llu %.6f %.3f\n", g_n, (unsigned long long)length,
+                   (double)length / ((double)g_n * (double)g_n), secondsSince(&start));
+            fflush(stdout);
+        }
+    } else {
+        printf("Enter grid size (1 to %d): ", MAX_N);
+        if (scanf("%d", &g_n) != 1 || g_n < 1 || g_n > MAX_N) {
+            printf("Invalid input. Please run again with n between 1 and %d.\n", MAX_N);
+            stopThreads();
+            return 1;
+        }
+        if (!allocBoard()) {
+            status = 1;
+        } else if (file ? !readPatternFile(file) : !fillPattern(pattern, density, seed)) {
+            printf("Could not %s %s\n", file ? "read" : "generate", file ? file : pattern);
+            status = 1;
+        } else {
+            WideBoard initial;
+            if (check && g_n <= WB_MAX_N)
+                initial = toWideBoard();
+
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            uint64_t length = denseLength();
+            double elapsed = secondsSince(&start);
+
+            printf("Length = %llu (%.4f n^2; 13/18 = %.4f)\n", (unsigned long long)length,
+                   (double)length / ((double)g_n * (double)g_n), 13.0 / 18.0);
+            printf("%.2f s, %.1f M steps/s, %d threads, %s rows\n", elapsed,
+                   (double)length / elapsed / 1e6, g_threadCount, g_stepRowName);
+
+            if (check) {
+                if (g_n > WB_MAX_N) {
+                    printf("--check compares with the WideBoard step and needs n <= %d\n", WB_MAX_N);
+                } else {
+                    int expected = wb_compute_length(initial, g_n);
+                    printf("WideBoard length = %d (%s)\n", expected,
+                           (uint64_t)expected == length ? "agrees" : "DISAGREES");
+                    status = ((uint64_t)expected != length);
+                }
+            }
+        }
+    }
+    stopThreads();
+    freeBoard();
+    return status;
+}
@@ -0,0 +1,609 @@
+/*
+  HashLife engine: exact lengths on grids with n up to 100000.
+
+  The grid is a quadtree of macrocells. A node of level k is a 2^k x 2^k
+  square made of four level k-1 children; level 0 is a single cell. Nodes
+  are hash-consed, so equal squares are the same node and comparing two
+  states is comparing two indices. advance(node, j) is the centre half of
+  a node 2^j steps later (j <= k-2), computed from nine overlapping
+  sub-squares in two rounds as in Gosper's algorithm and memoized on
+  (node, j). Repetitive structure, such as the rows of a snake, is
+  simulated once and reused across space and time.
+
+  The board needs no boundary handling: a cell outside the board has at
+  most one neighbour on it, so it never fills, and the evolution on the
+  infinite plane is the evolution on the board.
+
+  Finding the exact length: every step that changes anything fills a cell,
+  so the state is final after at most n*n steps, and the final state F is
+  one jump of 2^J >= n*n steps away. A state equals F exactly when it is
+  stable, so the first stable time is found by binary lifting: from the
+  last known unstable state, try jumps of 2^J, ..., 2, 1 and keep each
+  jump that does not land on F. Length = first stable time + 1, the same
+  count as compute_length.
+
+  Memory: nodes live in one array. After each jump, if there are more
+  than --max-nodes nodes, the ones not reachable from the current states
+  are dropped and the memo table is cleared.
+
+  Usage: hashlife [--pattern diagonal|snake|random] [--density P]
+                  [--seed S] [--file PATH] [--max-nodes N] [--check]
+         hashlife --self-check
+  With --file the initial cells are read from rows of text ('W', '#', 'x'
+  or '1' is a filled cell); --check compares with the WideBoard step for
+  n <= 32.
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "../core/wide_board.h"
+
+// ---------------------------------------------------------------------
+// Global variables
+// ---------------------------------------------------------------------
+static int g_n = 0;               // Board size, read from user
+#define MAX_LEVEL 40
+
+// ---------------------------------------------------------------------
+// Nodes. Index 0 is the empty cell and index 1 the filled cell; every
+// other node has four children with smaller indices.
+// ---------------------------------------------------------------------
+typedef struct {
+    uint32_t nw, ne, sw, se;
+    uint32_t next;                // hash chain
+    uint8_t level;
+} Node;
+
+static Node* g_nodes = NULL;
+static uint32_t g_nodeCount = 0;
+static uint32_t g_nodeCapacity = 0;
+static uint32_t* g_buckets = NULL;        // chain heads, UINT32_MAX = none
+static uint32_t g_bucketMask = 0;
+static uint32_t g_emptyNode[MAX_LEVEL + 1];
+static uint32_t g_maxNodes = 1u << 24;    // garbage collection threshold
+static int g_gcCount = 0;
+
+#define NO_NODE UINT32_MAX
+
+static inline uint32_t hashChildren(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint64_t h = (uint64_t)nw * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ ne) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ sw) * 0x94D049BB133111EBULL;
+    h = (h ^ se) * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(h >> 32);
+}
+
+static void rehashNodes(uint32_t bucketCount) {
+    free(g_buckets);
+    g_buckets = (uint32_t*)malloc(sizeof(uint32_t) * bucketCount);
+    memset(g_buckets, 0xFF, sizeof(uint32_t) * bucketCount);
+    g_bucketMask = bucketCount - 1;
+    for (uint32_t i = 2; i < g_nodeCount; i++) {
+        Node* x = &g_nodes[i];
+        uint32_t b = hashChildren(x->nw, x->ne, x->sw, x->se) & g_bucketMask;
+        x->next = g_buckets[b];
+        g_buckets[b] = i;
+    }
+}
+
+static uint32_t makeNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint32_t b = hashChildren(nw, ne, sw, se) & g_bucketMask;
+    for (uint32_t i = g_buckets[b]; i != NO_NODE; i = g_nodes[i].next) {
+        const Node* x = &g_nodes[i];
+        if (x->nw == nw && x->ne == ne && x->sw == sw && x->se == se)
+            return i;
+    }
+
+    if (g_nodeCount == g_nodeCapacity) {
+        if (g_nodeCapacity >= 0x80000000u) {
+            printf("Out of node indices\n");
+            exit(1);
+        }
+        g_nodeCapacity *= 2;
+        g_nodes = (Node*)realloc(g_nodes, sizeof(Node) * g_nodeCapacity);
+        if (!g_nodes) {
+            printf("Out of memory for %u nodes\n", g_nodeCapacity);
+            exit(1);
+        }
+    }
+    uint32_t i = g_nodeCount++;
+    Node* x = &g_nodes[i];
+    x->nw = nw;
+    x->ne = ne;
+    x->sw = sw;
+    x->se = se;
+    x->level = (uint8_t)(g_nodes[nw].level + 1);
+    x->next = g_buckets[b];
+    g_buckets[b] = i;
+    if (g_nodeCount > g_bucketMask)
+        rehashNodes(2 * (g_bucketMask + 1));
+    return i;
+}
+
+static void initNodes(void) {
+    g_nodeCapacity = 1u << 16;
+    g_nodes = (Node*)malloc(sizeof(Node) * g_nodeCapacity);
+    memset(g_nodes, 0, 2 * sizeof(Node));     // the two cells, level 0
+    g_nodeCount = 2;
+    rehashNodes(1u << 16);
+    g_emptyNode[0] = 0;
+    for (int k = 1; k <= MAX_LEVEL; k++) {
+        uint32_t e = g_emptyNode[k - 1];
+        g_emptyNode[k] = makeNode(e, e, e, e);
+    }
+}
+
+static inline int nodeLevel(uint32_t i) {
+    return g_nodes[i].level;
+}
+
+// ---------------------------------------------------------------------
+// Memo table: (node, j) -> advance(node, j)
+// ---------------------------------------------------------------------
+typedef struct {
+    uint64_t key;                 // node << 6 | j, 0 = free (node 0 is a cell)
+    uint32_t result;
+} MemoEntry;
+
+static MemoEntry* g_memo = NULL;
+static size_t g_memoMask = 0;
+static size_t g_memoCount = 0;
+
+static void initMemo(size_t capacity) {
+    free(g_memo);
+    g_memo = (MemoEntry*)calloc(capacity, sizeof(MemoEntry));
+    g_memoMask = capacity - 1;
+    g_memoCount = 0;
+}
+
+static inline size_t memoSlot(uint64_t key) {
+    key *= 0x9E3779B97F4A7C15ULL;
+    return (size_t)(key ^ (key >> 32)) & g_memoMask;
+}
+
+static uint32_t memoFind(uint64_t key) {
+    for (size_t i = memoSlot(key); g_memo[i].key; i = (i + 1) & g_memoMask) {
+        if (g_memo[i].key == key)
+            return g_memo[i].result;
+    }
+    return NO_NODE;
+}
+
+static void memoInsert(uint64_t key, uint32_t result) {
+    if (2 * (g_memoCount + 1) > g_memoMask + 1) {
+        MemoEntry* old = g_memo;
+        size_t oldCapacity = g_memoMask + 1;
+        g_memo = (MemoEntry*)calloc(2 * oldCapacity, sizeof(MemoEntry));
+        g_memoMask = 2 * oldCapacity - 1;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (old[i].key) {
+                size_t s = memoSlot(old[i].key);
+                while (g_memo[s].key)
+                    s = (s + 1) & g_memoMask;
+                g_memo[s] = old[i];
+            }
+        }
+        free(old);
+    }
+    size_t i = memoSlot(key);
+    while (g_memo[i].key)
+        i = (i + 1) & g_memoMask;
+    g_memo[i].key = key;
+    g_memo[i].result = result;
+    g_memoCount++;
+}
+
+// ---------------------------------------------------------------------
+// The step rule on the 4x4 base case, and the recursion above it
+// ---------------------------------------------------------------------
+// Centre 2x2 of a level 2 node after one step
+static uint32_t baseStep(uint32_t n) {
+    const Node* x = &g_nodes[n];
+    uint32_t q[4] = { x->nw, x->ne, x->sw, x->se };
+    int cell[4][4];
+    for (int i = 0; i < 4; i++) {
+        const Node* c = &g_nodes[q[i]];
+        int ox = (i & 1) * 2, oy = (i >> 1) * 2;
+        cell[oy][ox]         = (int)c->nw;
+        cell[oy][ox + 1]     = (int)c->ne;
+        cell[oy + 1][ox]     = (int)c->sw;
+        cell[oy + 1][ox + 1] = (int)c->se;
+    }
+    uint32_t r[4];
+    for (int i = 0; i < 4; i++) {
+        int cx = 1 + (i & 1), cy = 1 + (i >> 1);
+        int near = cell[cy][cx - 1] + cell[cy][cx + 1] + cell[cy - 1][cx] + cell[cy + 1][cx];
+        r[i] = (uint32_t)(cell[cy][cx] | (near >= 2));
+    }
+    return makeNode(r[0], r[1], r[2], r[3]);
+}
+
+// The level k-1 square in the middle of a level k node
+static uint32_t centre(uint32_t n) {
+    const Node x = g_nodes[n];
+    return makeNode(g_nodes[x.nw].se, g_nodes[x.ne].sw, g_nodes[x.sw].ne, g_nodes[x.se].nw);
+}
+
+// Centre half of node n after 2^j steps (j <= level - 2)
+static uint32_t advance(uint32_t n, int j) {
+    int k = nodeLevel(n);
+    if (n == g_emptyNode[k])
+        return g_emptyNode[k - 1];
+    uint64_t key = ((uint64_t)n << 6) | (uint64_t)j;
+    uint32_t found = memoFind(key);
+    if (found != NO_NODE)
+        return found;
+
+    uint32_t result;
+    if (k == 2) {
+        result = baseStep(n);
+    } else {
+        const Node x = g_nodes[n];
+        const Node a = g_nodes[x.nw], b = g_nodes[x.ne];
+        const Node c = g_nodes[x.sw], d = g_nodes[x.se];
+
+        // nine overlapping level k-1 squares
+        uint32_t s[3][3];
+        s[0][0] = x.nw;
+        s[0][1] = makeNode(a.ne, b.nw, a.se, b.sw);
+        s[0][2] = x.ne;
+        s[1][0] = makeNode(a.sw, a.se, c.nw, c.ne);
+        s[1][1] = makeNode(a.se, b.sw, c.ne, d.nw);
+        s[1][2] = makeNode(b.sw, b.se, d.nw, d.ne);
+        s[2][0] = x.sw;
+        s[2][1] = makeNode(c.ne, d.nw, c.se, d.sw);
+        s[2][2] = x.se;
+
+        // first half of the time (none if j < k-2), then the rest
+        int full = (j == k - 2);
+        uint32_t r[3][3];
+        for (int y = 0; y < 3; y++) {
+            for (int xx = 0; xx < 3; xx++)
+                r[y][xx] = full ? advance(s[y][xx], k - 3) : centre(s[y][xx]);
+        }
+        int rest = full ? k - 3 : j;
+        uint32_t nw = advance(makeNode(r[0][0], r[0][1], r[1][0], r[1][1]), rest);
+        uint32_t ne = advance(makeNode(r[0][1], r[0][2], r[1][1], r[1][2]), rest);
+        uint32_t sw = advance(makeNode(r[1][0], r[1][1], r[2][0], r[2][1]), rest);
+        uint32_t se = advance(makeNode(r[1][1], r[1][2], r[2][1], r[2][2]), rest);
+        result = makeNode(nw, ne, sw, se);
+    }
+    memoInsert(key, result);
+    return result;
+}
+
+// A level k+1 node with n in its centre
+static uint32_t expand(uint32_t n) {
+    const Node x = g_nodes[n];
+    uint32_t e = g_emptyNode[x.level - 1];
+    return makeNode(makeNode(e, e, e, x.nw), makeNode(e, e, x.ne, e),
+                    makeNode(e, x.sw, e, e), makeNode(x.se, e, e, e));
+}
+
+// The root 2^j steps later, as a node of the same level and position.
+// Nothing ever leaves the board, so the padding stays empty.
+static uint32_t jump(uint32_t root, int j) {
+    int k = nodeLevel(root);
+    uint32_t m = expand(root);
+    while (nodeLevel(m) < j + 2)
+        m = expand(m);
+    uint32_t r = advance(m, j);
+    while (nodeLevel(r) > k)
+        r = centre(r);
+    return r;
+}
+
+// ---------------------------------------------------------------------
+// Garbage collection: keep what the roots reach, renumbered in the same
+// order (children before parents), and forget the memo table
+// ---------------------------------------------------------------------
+static void collectGarbage(uint32_t* roots, int rootCount) {
+    uint8_t* live = (uint8_t*)calloc(g_nodeCount, 1);
+    live[0] = live[1] = 1;
+    for (int k = 1; k <= MAX_LEVEL; k++)
+        live[g_emptyNode[k]] = 1;
+    for (int r = 0; r < rootCount; r++)
+        live[roots[r]] = 1;
+    // parents have larger indices, so one downward pass marks everything
+    for (uint32_t i = g_nodeCount; i-- > 2; ) {
+        if (!live[i])
+            continue;
+        const Node* x = &g_nodes[i];
+        live[x->nw] = live[x->ne] = live[x->sw] = live[x->se] = 1;
+    }
+
+    uint32_t* remap = (uint32_t*)malloc(sizeof(uint32_t) * g_nodeCount);
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < g_nodeCount; i++) {
+        if (!live[i])
+            continue;
+        remap[i] = count;
+        Node x = g_nodes[i];
+        if (i >= 2) {
+            x.nw = remap[x.nw];
+            x.ne = remap[x.ne];
+            x.sw = remap[x.sw];
+            x.se = remap[x.se];
+        }
+        g_nodes[count++] = x;
+    }
+    g_nodeCount = count;
+    for (int k = 0; k <= MAX_LEVEL; k++)
+        g_emptyNode[k] = remap[g_emptyNode[k]];
+    for (int r = 0; r < rootCount; r++)
+        roots[r] = remap[roots[r]];
+    rehashNodes(g_bucketMask + 1);
+    initMemo(1u << 16);
+    free(remap);
+    free(live);
+    g_gcCount++;
+}
+
+// ---------------------------------------------------------------------
+// Initial states: a bit array of n rows, built into a quadtree
+// ---------------------------------------------------------------------
+static uint64_t* g_cells = NULL;          // n rows of g_words words
+static int g_words = 0;
+
+static inline int cellFilled(int x, int y) {
+    if (x >= g_n || y >= g_n)
+        return 0;
+    return (int)((g_cells[(size_t)y * g_words + (x >> 6)] >> (x & 63)) & 1ULL);
+}
+
+static inline void setCell(int x, int y) {
+    g_cells[(size_t)y * g_words + (x >> 6)] |= 1ULL << (x & 63);
+}
+
+static uint32_t buildNode(int level, int x0, int y0) {
+    if (x0 >= g_n || y0 >= g_n)
+        return g_emptyNode[level];
+    if (level == 0)
+        return (uint32_t)cellFilled(x0, y0);
+    if (level == 6) {
+        // one word per row: skip empty 64x64 blocks without visiting cells
+        uint64_t any = 0;
+        for (int y = y0; y < y0 + 64 && y < g_n; y++)
+            any |= g_cells[(size_t)y * g_words + (x0 >> 6)];
+        if (!any)
+            return g_emptyNode[6];
+    }
+    int h = 1 << (level - 1);
+    return makeNode(buildNode(level - 1, x0, y0), buildNode(level - 1, x0 + h, y0),
+                    buildNode(level - 1, x0, y0 + h), buildNode(level - 1, x0 + h, y0 + h));
+}
+
+static uint64_t xorshift64(uint64_t* s) {
+    uint64_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *s = x;
+}
+
+// T3's diagonal (length n), the snake (row 0 full and one trigger cell on
+// alternate sides of every other row), or random cells
+static int fillPattern(const char* pattern, double density, uint64_t seed) {
+    if (strcmp(pattern, "diagonal") == 0) {
+        for (int i = 0; i < g_n; i++)
+            setCell(i, i);
+    } else if (strcmp(pattern, "snake") == 0) {
+        for (int x = 0; x < g_n; x++)
+            setCell(x, 0);
+        for (int y = 2, side = 0; y < g_n; y += 2, side ^= 1)
+            setCell(side ? g_n - 1 : 0, y);
+    } else if (strcmp(pattern, "random") == 0) {
+        uint64_t rng = seed ? seed : 0x9E3779B97F4A7C15ULL;
+        uint64_t threshold = (uint64_t)(density * 18446744073709551615.0);
+        for (int y = 0; y < g_n; y++) {
+            for (int x = 0; x < g_n; x++) {
+                if (xorshift64(&rng) < threshold)
+                    setCell(x, y);
+            }
+        }
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+static int readPatternFile(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f)
+        return 0;
+    // Character by character: rows can be up to 100000 wide, and anything
+    // past column n is skipped rather than read as the next row
+    int x = 0, y = 0, ch;
+    while (y < g_n && (ch = getc(f)) != EOF) {
+        if (ch == '\n') {
+            x = 0;
+            y++;
+        } else {
+            if (x < g_n && (ch == 'W' || ch == '#' || ch == 'x' || ch == '1'))
+                setCell(x, y);
+            x++;
+        }
+    }
+    fclose(f);
+    return 1;
+}
+
+// ---------------------------------------------------------------------
+// The length of the current g_cells by binary lifting
+// ---------------------------------------------------------------------
+static int topLevel(void) {
+    int k = 1;
+    while ((1 << k) < g_n)
+        k++;
+    return k;
+}
+
+static uint64_t hashlifeLength(int verbose) {
+    uint32_t roots[2];
+    roots[0] = buildNode(topLevel(), 0, 0);       // current unstable state
+
+    int J = 0;
+    while ((1ULL << J) < (uint64_t)g_n * (uint64_t)g_n)
+        J++;
+    roots[1] = jump(roots[0], J);                  // the final state
+    if (roots[0] == roots[1])
+        return 1;
+
+    uint64_t t = 0;                                // roots[0] is state(t)
+    for (int j = J; j >= 0; j--) {
+        uint32_t next = jump(roots[0], j);
+        if (next != roots[1]) {
+            roots[0] = next;
+            t += 1ULL << j;
+        }
+        if (g_nodeCount > g_maxNodes) {
+            collectGarbage(roots, 2);
+            if (verbose)
+                printf("GC: %u nodes live after the 2^%d jump\n", g_nodeCount, j);
+        }
+        if (verbose >= 2)
+            printf("2^%d: t = %llu, %u nodes, %zu memo entries\n", j,
+                   (unsigned long long)t, g_nodeCount, g_memoCount);
+    }
+    // state(t) is the last unstable one, so the first stable time is t+1
+    return t + 2;
+}
+
+// ---------------------------------------------------------------------
+// Self-check against the WideBoard step
+// ---------------------------------------------------------------------
+static WideBoard toWideBoard(void) {
+    WideBoard b;
+    wb_clear(&b);
+    for (int y = 0; y < g_n; y++) {
+        for (int x = 0; x < g_n; x++) {
+            if (cellFilled(x, y))
+                wb_fillCell(&b, x, y);
+        }
+    }
+    return b;
+}
+
+static void allocCells(void) {
+    free(g_cells);
+    g_words = (g_n + 63) / 64;
+    g_cells = (uint64_t*)calloc((size_t)g_n * (size_t)g_words, sizeof(uint64_t));
+}
+
+static int runSelfCheck(void) {
+    uint64_t rng = 0x123456789ABCDEFULL;
+    for (g_n = 1; g_n <= WB_MAX_N; g_n++) {
+        for (int i = 0; i < 64; i++) {
+            allocCells();
+            const char* pattern = (i == 0) ? "snake" : (i == 1) ? "diagonal" : "random";
+            double density = 0.02 + 0.2 * (double)(xorshift64(&rng) % 1000) / 1000.0;
+            fillPattern(pattern, density, xorshift64(&rng));
+            uint64_t got = hashlifeLength(0);
+            int expected = wb_compute_length(toWideBoard(), g_n);
+            if (got != (uint64_t)expected) {
+                printf("HashLife length %llu != %d for n = %d (%s)\n",
+                       (unsigned long long)got, expected, g_n, pattern);
+                return 1;
+            }
+        }
+    }
+    // a tiny threshold forces a collection after every jump
+    g_maxNodes = 64;
+    for (g_n = 20; g_n <= WB_MAX_N; g_n += 4) {
+        allocCells();
+        fillPattern("snake", 0.0, 0);
+        uint64_t got = hashlifeLength(0);
+        if (got != (uint64_t)wb_compute_length(toWideBoard(), g_n)) {
+            printf("HashLife length changed by garbage collection for n = %d\n", g_n);
+            return 1;
+        }
+    }
+    printf("Self-check passed (%d collections)\n", g_gcCount);
+    return 0;
+}
+
+static double secondsSince(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + 1e-9 * (double)(now.tv_nsec - start->tv_nsec);
+}
+
+// ---------------------------------------------------------------------
+// main()
+// ---------------------------------------------------------------------
+int main(int argc, char **argv) {
+    const char* pattern = "snake";
+    const char* file = NULL;
+    double density = 0.1;
+    uint64_t seed = 0;
+    int check = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--self-check") == 0) {
+            initNodes();
+            initMemo(1u << 16);
+            return runSelfCheck();
+        } else if (strcmp(argv[a], "--pattern") == 0 && a + 1 < argc) {
+            pattern = argv[++a];
+        } else if (strcmp(argv[a], "--density") == 0 && a + 1 < argc) {
+            density = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) {
+            seed = strtoull(argv[++a], NULL, 10);
+        } else if (strcmp(argv[a], "--file") == 0 && a + 1 < argc) {
+            file = argv[++a];
+        } else if (strcmp(argv[a], "--max-nodes") == 0 && a + 1 < argc) {
+            g_maxNodes = (uint32_t)strtoul(argv[++a], NULL, 10);
+        } else if (strcmp(argv[a], "--check") == 0) {
+            check = 1;
+        } else {
+            printf("Usage: %s [--pattern diagonal|snake|random] [--density P] [--seed S]\n"
+                   "       [--file PATH] [--max-nodes N] [--check]\n"
+                   "       %s --self-check\n", argv[0], argv[0]);
+            return 1;
+        }
+    }
+
+    printf("Enter grid size (1 to 100000): ");
+    if (scanf("%d", &g_n) != 1 || g_n < 1 || g_n > 100000) {
+        printf("Invalid input. Please run again with n between 1 and 100000.\n");
+        return 1;
+    }
+
+    initNodes();
+    initMemo(1u << 16);
+    allocCells();
+    if (file ? !readPatternFile(file) : !fillPattern(pattern, density, seed)) {
+        printf("Could not %s %s\n", file ? "read" : "generate", file ? file : pattern);
+        return 1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t length = hashlifeLength(1);
+    double elapsed = secondsSince(&start);
+
+    printf("Length = %llu (%.4f n^2; 13/18 = %.4f)\n", (unsigned long long)length,
+           (double)length / ((double)g_n * (double)g_n), 13.0 / 18.0);
+    printf("%.2f s, %u nodes, %zu memo entries, %d collections\n",
+           elapsed, g_nodeCount, g_memoCount, g_gcCount);
+
+    int status = 0;
+    if (check) {
+        if (g_n > WB_MAX_N) {
+            printf("--check compares with the WideBoard step and needs n <= %d\n", WB_MAX_N);
+        } else {
+            int expected = wb_compute_length(toWideBoard(), g_n);
+            printf("WideBoard length = %d (%s)\n", expected,
+                   (uint64_t)expected == length ? "agrees" : "DISAGREES");
+            status = ((uint64_t)expected != length);
+        }
+    }
+    free(g_cells);
+    free(g_nodes);
+    free(g_buckets);
+    free(g_memo);
+    return status;
+}
@@ -0,0 +1,641 @@
+/*
+  Metaheuristic search for long states, to improve the lower bounds on
+  f(n) where exhaustive search cannot reach (n = 7..12 and beyond).
+
+  A candidate is a set of initial cells. Three neighbourhood moves change
+  it:
+    - flip:  toggle one cell anywhere on the board
+    - move:  move one initial cell to an empty cell at most 2 steps away
+    - swap:  move one initial cell to any empty cell
+  and three search modes use them:
+    - sa:    simulated annealing; the temperature falls geometrically
+             over each epoch and every epoch restarts from an elite
+    - tabu:  each iteration samples a few moves and takes the best one
+             whose cells were not touched in the last few iterations
+             (a tabu move is allowed if it beats the best so far)
+    - ga:    a small population per thread; tournament selection,
+             rectangle crossover (a random rectangle from one parent,
+             the rest from the other) and mutation by moves
+
+  Lengths come from the whole-board water_length (core/water.h) for
+  n <= 8 and the frontier-driven WideBoard kernel (wide_board.h) for
+  larger n.
+
+  Every thread has its own RNG and runs a fixed number of evaluations per
+  epoch. At the end of an epoch all threads meet at a barrier, thread 0
+  merges their best candidates into a shared pool of elites (distinct up
+  to symmetry), and after a second barrier every thread seeds its next
+  epoch from that pool. With --seed and --epochs a run is deterministic:
+  the same seed and thread count give the same result. --seconds and
+  --target are only checked at the barrier, so they end a run after a
+  whole epoch.
+
+  Usage: local_search [--mode sa|tabu|ga] [--threads N] [--seed S]
+                      [--epochs E] [--seconds S] [--epoch-evals K]
+                      [--target L]
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>  // For C11 atomics
+
+#ifdef _WIN32
+#include <windows.h>  // for GetSystemInfo()
+#else
+#include <unistd.h>   // for sysconf() on Linux/macOS
+#endif
+
+#include "../core/wide_board.h"
+#include "../core/water.h"
+
+// ---------------------------------------------------------------------
+// Global variables
+// ---------------------------------------------------------------------
+static int g_n = 0;               // Board size, read from user
+static WaterContext g_ctx;        // packed evaluator, n <= 8 only
+
+static inline int cellIndex(int x, int y) {
+    return y * g_n + x;
+}
+
+// ---------------------------------------------------------------------
+// Evaluation: the packed whole-board kernel (core/water.h) for n <= 8
+// ---------------------------------------------------------------------
+static inline int evaluateBoard(const WideBoard *b) {
+    if (g_n <= 8)
+        return water_length(&g_ctx, wb_toPacked(b, g_n));
+    return wb_compute_length_frontier(*b, g_n);
+}
+
+// ---------------------------------------------------------------------
+// Per-thread RNG: xoshiro256**, seeded through splitmix64
+// ---------------------------------------------------------------------
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void rngSeed(Rng *r, uint64_t seed) {
+    for (int i = 0; i < 4; i++)
+        r->s[i] = splitmix64(&seed);
+}
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rngNext(Rng *r) {
+    uint64_t result = rotl64(r->s[1] * 5, 7) * 9;
+    uint64_t t = r->s[1] << 17;
+    r->s[2] ^= r->s[0];
+    r->s[3] ^= r->s[1];
+    r->s[1] ^= r->s[2];
+    r->s[0] ^= r->s[3];
+    r->s[2] ^= t;
+    r->s[3] = rotl64(r->s[3], 45);
+    return result;
+}
+
+static inline int rngBelow(Rng *r, int bound) {
+    return (int)((rngNext(r) >> 32) * (uint64_t)bound >> 32);
+}
+
+static inline double rngUnit(Rng *r) {
+    return (double)(rngNext(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// ---------------------------------------------------------------------
+// Candidates: a board plus the list of its initial cells
+// ---------------------------------------------------------------------
+#define MAX_FILLED (4 * WB_MAX_N)
+
+typedef struct {
+    WideBoard board;
+    int cells[MAX_FILLED];
+    int count;
+    int length;
+} Candidate;
+
+static inline int candidateHas(const Candidate *c, int cell) {
+    return wb_isFilled(&c->board, cell % g_n, cell / g_n);
+}
+
+static void candidateAdd(Candidate *c, int cell) {
+    wb_fillCell(&c->board, cell % g_n, cell / g_n);
+    c->cells[c->count++] = cell;
+}
+
+static void candidateRemoveAt(Candidate *c, int i) {
+    int cell = c->cells[i];
+    wb_unfillCell(&c->board, cell % g_n, cell / g_n);
+    c->cells[i] = c->cells[--c->count];
+}
+
+// Rebuild the cell list after the board was changed directly
+static void candidateSync(Candidate *c, Rng *rng) {
+    c->count = 0;
+    for (int y = 0; y < g_n; y++) {
+        for (uint32_t row = c->board.row[y]; row; row &= row - 1) {
+            int cell = cellIndex(__builtin_ctz(row), y);
+            if (c->count < MAX_FILLED) {
+                c->cells[c->count++] = cell;
+            } else {
+                // too many cells: keep a random subset
+                int i = rngBelow(rng, MAX_FILLED);
+                int old = c->cells[i];
+                wb_unfillCell(&c->board, old % g_n, old / g_n);
+                c->cells[i] = cell;
+            }
+        }
+    }
+}
+
+// Copies only the used part of the cell list
+static inline void candidateCopy(Candidate *dst, const Candidate *src) {
+    dst->board = src->board;
+    dst->count = src->count;
+    dst->length = src->length;
+    memcpy(dst->cells, src->cells, sizeof(int) * (size_t)src->count);
+}
+
+static void candidateEvaluate(Candidate *c, uint64_t *evaluations) {
+    c->length = evaluateBoard(&c->board);
+    (*evaluations)++;
+}
+
+static void randomCandidate(Candidate *c, Rng *rng) {
+    wb_clear(&c->board);
+    c->count = 0;
+    int cells = g_n * g_n;
+    int target = g_n + rngBelow(rng, 3);
+    if (target > cells)
+        target = cells;
+    while (c->count < target) {
+        int cell = rngBelow(rng, cells);
+        if (!candidateHas(c, cell))
+            candidateAdd(c, cell);
+    }
+}
+
+// ---------------------------------------------------------------------
+// Neighbourhood moves. A move removes at most one cell and adds at most
+// one; 'touched' gets the cells it changed (for the tabu list).
+// ---------------------------------------------------------------------
+enum { MOVE_FLIP, MOVE_SHIFT, MOVE_SWAP };
+
+static int randomEmptyCell(const Candidate *c, Rng *rng) {
+    int cells = g_n * g_n;
+    if (c->count >= cells)
+        return -1;
+    for (;;) {
+        int cell = rngBelow(rng, cells);
+        if (!candidateHas(c, cell))
+            return cell;
+    }
+}
+
+// Applies a random move to c; returns 0 if none was possible
+static int applyRandomMove(Candidate *c, Rng *rng, int touched[2]) {
+    touched[0] = touched[1] = -1;
+    int kind = rngBelow(rng, 10);
+    kind = (kind < 2) ? MOVE_FLIP : (kind < 7) ? MOVE_SHIFT : MOVE_SWAP;
+    if (c->count == 0)
+        kind = MOVE_FLIP;
+
+    if (kind == MOVE_FLIP) {
+        int cell = rngBelow(rng, g_n * g_n);
+        if (candidateHas(c, cell)) {
+            for (int i = 0; i < c->count; i++) {
+                if (c->cells[i] == cell) {
+                    candidateRemoveAt(c, i);
+                    break;
+                }
+            }
+        } else {
+            if (c->count == MAX_FILLED)
+                return 0;
+            candidateAdd(c, cell);
+        }
+        touched[0] = cell;
+        return 1;
+    }
+
+    int i = rngBelow(rng, c->count);
+    int from = c->cells[i];
+    int to;
+    if (kind == MOVE_SHIFT) {
+        int dx, dy;
+        do {
+            dx = rngBelow(rng, 5) - 2;
+            dy = rngBelow(rng, 5) - 2;
+        } while ((dx == 0 && dy == 0) || abs(dx) + abs(dy) > 2);
+        int x = from % g_n + dx, y = from / g_n + dy;
+        if (x < 0 || x >= g_n || y < 0 || y >= g_n)
+            return 0;
+        to = cellIndex(x, y);
+        if (candidateHas(c, to))
+            return 0;
+    } else {
+        to = randomEmptyCell(c, rng);
+        if (to < 0)
+            return 0;
+    }
+    candidateRemoveAt(c, i);
+    candidateAdd(c, to);
+    touched[0] = from;
+    touched[1] = to;
+    return 1;
+}
+
+// ---------------------------------------------------------------------
+// Elite pool, shared between epochs. Only thread 0 writes it, between
+// two barriers, so it needs no lock.
+// ---------------------------------------------------------------------
+#define ELITE_COUNT 8
+
+static Candidate g_elite[ELITE_COUNT];
+static int g_eliteCount = 0;
+
+static int sameUpToSymmetry(const Candidate *a, const Candidate *b) {
+    WideBoard ca, cb;
+    wb_canonical(&a->board, g_n, &ca);
+    wb_canonical(&b->board, g_n, &cb);
+    return wb_equal(&ca, &cb, g_n);
+}
+
+static void offerElite(const Candidate *c) {
+    for (int i = 0; i < g_eliteCount; i++) {
+        if (g_elite[i].length == c->length && sameUpToSymmetry(&g_elite[i], c))
+            return;
+    }
+    int pos = g_eliteCount;
+    if (pos == ELITE_COUNT) {
+        if (c->length <= g_elite[ELITE_COUNT - 1].length)
+            return;
+        pos = ELITE_COUNT - 1;
+    } else {
+        g_eliteCount++;
+    }
+    // keep the pool sorted, longest first (ties: older entries first)
+    while (pos > 0 && g_elite[pos - 1].length < c->length) {
+        g_elite[pos] = g_elite[pos - 1];
+        pos--;
+    }
+    g_elite[pos] = *c;
+}
+
+// ---------------------------------------------------------------------
+// Search modes. Each runs one epoch of 'budget' evaluations starting
+// from the elite pool (or random candidates before the first exchange)
+// and leaves its best candidate in task->best.
+// ---------------------------------------------------------------------
+enum { MODE_SA, MODE_TABU, MODE_GA };
+
+#define GA_POPULATION 32
+#define GA_KEEP 2             // best individuals carried over unchanged
+#define TABU_SAMPLES 16
+#define TABU_TENURE 7
+
+typedef struct {
+    _Alignas(64) _Atomic uint64_t evaluations;   // read by the main thread
+    int id;
+    Rng rng;
+    Candidate best;                              // best seen this run
+    Candidate current;                           // sa/tabu state
+    Candidate* population;                       // ga
+    int* tabuUntil;                              // tabu
+    uint64_t localEvaluations;
+} ThreadTask;
+
+static int g_mode = MODE_SA;
+static int g_threadCount = 1;
+static uint64_t g_epochEvals = 20000;
+
+static inline void noteBest(ThreadTask *task, const Candidate *c) {
+    if (c->length > task->best.length)
+        task->best = *c;
+}
+
+// Elite to start from: spread the threads over the pool
+static void startingPoint(ThreadTask *task, int epoch, Candidate *c) {
+    if (g_eliteCount == 0) {
+        randomCandidate(c, &task->rng);
+        candidateEvaluate(c, &task->localEvaluations);
+    } else {
+        *c = g_elite[(task->id + epoch) % g_eliteCount];
+    }
+}
+
+static void epochAnnealing(ThreadTask *task, int epoch) {
+    const double t0 = 2.0, t1 = 0.05;
+    Candidate *cur = &task->current;
+    startingPoint(task, epoch, cur);
+    noteBest(task, cur);
+
+    double cooling = pow(t1 / t0, 1.0 / (double)g_epochEvals);
+    double temperature = t0;
+    Candidate next;
+    for (uint64_t e = 0; e < g_epochEvals; ) {
+        candidateCopy(&next, cur);
+        int touched[2];
+        if (!applyRandomMove(&next, &task->rng, touched))
+            continue;
+        candidateEvaluate(&next, &task->localEvaluations);
+        e++;
+        temperature *= cooling;
+        int delta = next.length - cur->length;
+        if (delta >= 0 || rngUnit(&task->rng) < exp((double)delta / temperature)) {
+            candidateCopy(cur, &next);
+            noteBest(task, cur);
+        }
+    }
+}
+
+static void epochTabu(ThreadTask *task, int epoch) {
+    Candidate *cur = &task->current;
+    startingPoint(task, epoch, cur);
+    noteBest(task, cur);
+    memset(task->tabuUntil, 0, sizeof(int) * (size_t)(g_n * g_n));
+
+    int iteration = 0;
+    for (uint64_t e = 0; e < g_epochEvals; iteration++) {
+        Candidate bestMove;
+        int bestTouched[2] = { -1, -1 };
+        int found = 0;
+        for (int k = 0; k < TABU_SAMPLES && e < g_epochEvals; k++) {
+            Candidate next;
+            candidateCopy(&next, cur);
+            int touched[2];
+            if (!applyRandomMove(&next, &task->rng, touched))
+                continue;
+            candidateEvaluate(&next, &task->localEvaluations);
+            e++;
+            int tabu = (touched[0] >= 0 && task->tabuUntil[touched[0]] > iteration)
+                    || (touched[1] >= 0 && task->tabuUntil[touched[1]] > iteration);
+            if (tabu && next.length <= task->best.length)
+                continue;                   // aspiration: only a new best may break tabu
+            if (!found || next.length > bestMove.length) {
+                candidateCopy(&bestMove, &next);
+                bestTouched[0] = touched[0];
+                bestTouched[1] = touched[1];
+                found = 1;
+            }
+        }
+        if (!found)
+            continue;
+        candidateCopy(cur, &bestMove);
+        noteBest(task, cur);
+        for (int i = 0; i < 2; i++) {
+            if (bestTouched[i] >= 0)
+                task->tabuUntil[bestTouched[i]] = iteration + TABU_TENURE;
+        }
+    }
+}
+
+static int tournament(ThreadTask *task) {
+    int best = rngBelow(&task->rng, GA_POPULATION);
+    for (int k = 0; k < 2; k++) {
+        int other = rngBelow(&task->rng, GA_POPULATION);
+        if (task->population[other].length > task->population[best].length)
+            best = other;
+    }
+    return best;
+}
+
+static int compareLengthDesc(const void *a, const void *b) {
+    return ((const Candidate *)b)->length - ((const Candidate *)a)->length;
+}
+
+static void epochGenetic(ThreadTask *task, int epoch) {
+    Candidate *pop = task->population;
+    if (epoch == 0) {
+        for (int i = 0; i < GA_POPULATION; i++) {
+            randomCandidate(&pop[i], &task->rng);
+            candidateEvaluate(&pop[i], &task->localEvaluations);
+        }
+    } else {
+        // the elites replace the weakest individuals
+        for (int i = 0; i < g_eliteCount && i < GA_POPULATION / 4; i++)
+            pop[GA_POPULATION - 1 - i] = g_elite[(task->id + i) % g_eliteCount];
+    }
+    qsort(pop, GA_POPULATION, sizeof(Candidate), compareLengthDesc);
+    noteBest(task, &pop[0]);
+
+    Candidate *next = (Candidate *)malloc(sizeof(Candidate) * GA_POPULATION);
+    for (uint64_t e = 0; e < g_epochEvals; ) {
+        for (int i = 0; i < GA_KEEP; i++)
+            next[i] = pop[i];
+        for (int i = GA_KEEP; i < GA_POPULATION; i++) {
+            const Candidate *a = &pop[tournament(task)];
+            const Candidate *b = &pop[tournament(task)];
+
+            // rectangle crossover
+            int x0 = rngBelow(&task->rng, g_n), x1 = rngBelow(&task->rng, g_n);
+            int y0 = rngBelow(&task->rng, g_n), y1 = rngBelow(&task->rng, g_n);
+            if (x0 > x1) { int t = x0; x0 = x1; x1 = t; }
+            if (y0 > y1) { int t = y0; y0 = y1; y1 = t; }
+            uint32_t span = (uint32_t)((((uint64_t)1 << (x1 - x0 + 1)) - 1) << x0);
+            Candidate *child = &next[i];
+            for (int y = 0; y < g_n; y++) {
+                uint32_t inside = (y >= y0 && y <= y1) ? span : 0u;
+                child->board.row[y] = (a->board.row[y] & inside) | (b->board.row[y] & ~inside);
+            }
+            candidateSync(child, &task->rng);
+
+            int moves = 1 + rngBelow(&task->rng, 2);
+            for (int m = 0; m < moves; m++) {
+                int touched[2];
+                applyRandomMove(child, &task->rng, touched);
+            }
+            candidateEvaluate(child, &task->localEvaluations);
+            e++;
+        }
+        memcpy(pop, next, sizeof(Candidate) * GA_POPULATION);
+        qsort(pop, GA_POPULATION, sizeof(Candidate), compareLengthDesc);
+        noteBest(task, &pop[0]);
+    }
+    free(next);
+}
+
+// ---------------------------------------------------------------------
+// Worker threads and epochs
+// ---------------------------------------------------------------------
+static pthread_barrier_t g_barrier;
+static ThreadTask* g_tasks = NULL;
+static int g_maxEpochs = 0;           // 0 = no limit
+static double g_maxSeconds = 0.0;     // 0 = no limit
+static int g_target = 0;              // 0 = no target
+static int g_stop = 0;                // set by thread 0 between barriers
+static struct timespec g_start;
+
+static double secondsSince(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + 1e-9 * (double)(now.tv_nsec - start->tv_nsec);
+}
+
+static uint64_t totalEvaluations(void) {
+    uint64_t total = 0;
+    for (int i = 0; i < g_threadCount; i++)
+        total += atomic_load_explicit(&g_tasks[i].evaluations, memory_order_relaxed);
+    return total;
+}
+
+void* workerThreadFunc(void* arg) {
+    ThreadTask* task = (ThreadTask*)arg;
+    for (int epoch = 0; ; epoch++) {
+        if (g_mode == MODE_SA)
+            epochAnnealing(task, epoch);
+        else if (g_mode == MODE_TABU)
+            epochTabu(task, epoch);
+        else
+            epochGenetic(task, epoch);
+        // Only this thread writes its counter; the main thread sums them
+        atomic_store_explicit(&task->evaluations, task->localEvaluations, memory_order_relaxed);
+
+        pthread_barrier_wait(&g_barrier);
+        if (task->id == 0) {
+            // merge in thread order, so the pool does not depend on timing
+            for (int i = 0; i < g_threadCount; i++)
+                offerElite(&g_tasks[i].best);
+            double elapsed = secondsSince(&g_start);
+            uint64_t evaluations = totalEvaluations();
+            printf("Epoch %d: best length %d, %llu evaluations, %.3g evaluations/s\n",
+                   epoch + 1, g_elite[0].length, (unsigned long long)evaluations,
+                   elapsed > 0.0 ? (double)evaluations / elapsed : 0.0);
+            fflush(stdout);
+            g_stop = (g_maxEpochs > 0 && epoch + 1 >= g_maxEpochs)
+                  || (g_maxSeconds > 0.0 && elapsed >= g_maxSeconds)
+                  || (g_target > 0 && g_elite[0].length >= g_target);
+        }
+        pthread_barrier_wait(&g_barrier);
+        if (g_stop)
+            break;
+    }
+    return NULL;
+}
+
+static int defaultThreadCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+#endif
+}
+
+// ---------------------------------------------------------------------
+// main()
+// ---------------------------------------------------------------------
+int main(int argc, char **argv) {
+    int threadCount = defaultThreadCount();
+    uint64_t seed = 0;
+    int haveSeed = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--mode") == 0 && a + 1 < argc) {
+            const char* mode = argv[++a];
+            if (strcmp(mode, "sa") == 0)
+                g_mode = MODE_SA;
+            else if (strcmp(mode, "tabu") == 0)
+                g_mode = MODE_TABU;
+            else if (strcmp(mode, "ga") == 0)
+                g_mode = MODE_GA;
+            else {
+                printf("Unknown mode %s (sa, tabu or ga)\n", mode);
+                return 1;
+            }
+        } else if ((strcmp(argv[a], "--threads") == 0 || strcmp(argv[a], "-t") == 0) && a + 1 < argc) {
+            threadCount = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) {
+            seed = strtoull(argv[++a], NULL, 10);
+            haveSeed = 1;
+        } else if (strcmp(argv[a], "--epochs") == 0 && a + 1 < argc) {
+            g_maxEpochs = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--seconds") == 0 && a + 1 < argc) {
+            g_maxSeconds = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--epoch-evals") == 0 && a + 1 < argc) {
+            g_epochEvals = strtoull(argv[++a], NULL, 10);
+        } else if (strcmp(argv[a], "--target") == 0 && a + 1 < argc) {
+            g_target = atoi(argv[++a]);
+        } else {
+            printf("Usage: %s [--mode sa|tabu|ga] [--threads N] [--seed S]\n"
+                   "       [--epochs E] [--seconds S] [--epoch-evals K] [--target L]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (threadCount < 1 || g_epochEvals < 1) {
+        printf("Thread count and evaluations per epoch must be at least 1.\n");
+        return 1;
+    }
+    if (g_maxEpochs == 0 && g_maxSeconds == 0.0 && g_target == 0)
+        g_maxSeconds = 60.0;
+    if (!haveSeed)
+        seed = (uint64_t)time(NULL);
+
+    printf("Enter grid size (2 to %d): ", WB_MAX_N);
+    if (scanf("%d", &g_n) != 1 || g_n < 2 || g_n > WB_MAX_N) {
+        printf("Invalid input. Please run again with n between 2 and %d.\n", WB_MAX_N);
+        return 1;
+    }
+    if (g_n <= 8)
+        water_init(&g_ctx, g_n, 0);
+
+    static const char* modeNames[] = { "sa", "tabu", "ga" };
+    printf("Mode: %s, threads: %d, seed: %llu, %llu evaluations per thread and epoch\n",
+           modeNames[g_mode], threadCount, (unsigned long long)seed,
+           (unsigned long long)g_epochEvals);
+
+    g_threadCount = threadCount;
+    g_tasks = (ThreadTask*)aligned_alloc(_Alignof(ThreadTask), sizeof(ThreadTask) * threadCount);
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        ThreadTask* task = &g_tasks[i];
+        atomic_init(&task->evaluations, 0ULL);
+        task->id = i;
+        rngSeed(&task->rng, seed ^ (0xD1B54A32D192ED03ULL * (uint64_t)(i + 1)));
+        memset(&task->best, 0, sizeof(Candidate));
+        task->population = (g_mode == MODE_GA) ? (Candidate*)malloc(sizeof(Candidate) * GA_POPULATION) : NULL;
+        task->tabuUntil = (g_mode == MODE_TABU) ? (int*)malloc(sizeof(int) * (size_t)(g_n * g_n)) : NULL;
+        task->localEvaluations = 0;
+    }
+
+    pthread_barrier_init(&g_barrier, NULL, (unsigned)threadCount);
+    clock_gettime(CLOCK_MONOTONIC, &g_start);
+    for (int i = 0; i < threadCount; i++)
+        pthread_create(&threads[i], NULL, workerThreadFunc, &g_tasks[i]);
+    for (int i = 0; i < threadCount; i++)
+        pthread_join(threads[i], NULL);
+    pthread_barrier_destroy(&g_barrier);
+
+    double elapsed = secondsSince(&g_start);
+    uint64_t evaluations = totalEvaluations();
+    printf("Evaluations = %llu in %.1f s (%.3g evaluations/s over %d threads)\n",
+           (unsigned long long)evaluations, elapsed,
+           elapsed > 0.0 ? (double)evaluations / elapsed : 0.0, threadCount);
+    printf("Max length found = %d (%d initial cells)\n", g_elite[0].length, g_elite[0].count);
+    if (g_n <= 8)
+        printf("Best state = %" PRIu64 "\n", wb_toPacked(&g_elite[0].board, g_n));
+    wb_print(&g_elite[0].board, g_n);
+
+    for (int i = 0; i < threadCount; i++) {
+        free(g_tasks[i].population);
+        free(g_tasks[i].tabuUntil);
+    }
+    free(g_tasks);
+    free(threads);
+    return 0;
+}
@@ -0,0 +1,622 @@
+/*
+  f(n) by a transfer-matrix (profile) dynamic programme over fill times.
+
+  Give every cell its fill time: 0 for the initial cells, k if the cell
+  fills at step k, and INF if it never fills. These times satisfy, for
+  every cell that is not initial,
+
+      time(c) = 1 + (second smallest time among the neighbours of c)
+
+  (INF + 1 = INF, and cells off the board count as INF). Conversely any
+  labelling with this property, where the cells labelled 0 are the
+  initial ones, is the true evolution of those cells: by induction on the
+  true time a cell's label is never later, and by induction on the label
+  it is never earlier. So f(n) - 1 is the largest finite label over all
+  consistent labellings, and consistency is a local condition.
+
+  Rounds. A round asks whether some state is longer than K, and only
+  labels 0..K are kept: every later time, and INF, becomes HIGH. A cell
+  is HIGH iff at most one neighbour is labelled K-1 or less, and the rule
+  above is unchanged for labels up to K, so the truncated labellings are
+  exactly the true evolutions up to time K. Every time up to the last one
+  is used by some cell, so a state is longer than K iff its labelling
+  uses the label K. The first K is the incumbent: the longest state a
+  short hill climb finds, or --lower-bound if that is larger. Each round
+  that succeeds yields a witness, its true length L is measured with
+  water_length, and the next round asks for more than L. The first round
+  that fails proves f(n) = L.
+
+  The grid is labelled one cell at a time in row-major order. The profile
+  holds the last n labelled cells (the current row up to x-1 and the
+  previous row from x on), each with its label and what is known so far
+  about its neighbours:
+    a = number of neighbours labelled below time-1 (at most 1, two of
+        them would make the cell fill too early),
+    b = number of neighbours labelled exactly time-1 (capped).
+  A cell is consistent once all its neighbours are known iff a + b >= 2;
+  a HIGH cell only counts a (at most 1). Labelling (x, y) completes
+  (x, y-1), which leaves the profile, and is a neighbour of (x-1, y); a
+  profile is dropped as soon as a cell in it can no longer be completed.
+
+  Profiles are merged and dropped by these rules, all exact:
+
+  - Equal profiles are merged, keeping the largest label seen so far (and
+    a witness: the initial cells that reach it). At the end of a row a
+    profile is also merged with its mirror image.
+
+  - Incumbent: the labels between the largest one so far and K can only
+    go to cells not labelled yet, so a profile is dropped when its best
+    label plus the number of unlabelled cells is below K.
+
+  - Unreadable labels: a profile cell is read only by its unknown
+    neighbours. Once it has none (the last row, left of x-1) its slot is
+    cleared. With one left and a + b = 2 the cell accepts any label there,
+    and a label K reads like HIGH to every neighbour, so such a cell is
+    stored as HIGH.
+
+  - Triangle: the board's symmetries map any cell to one with
+    y <= min(x, n-1-x), so some image of every state takes its label K
+    there. Past the last such cell a profile without K is dropped. The
+    triangle is its own mirror image, so this agrees with the mirror
+    merge.
+
+  - Initial cells: an initial cell with two initial neighbours would be
+    filled by them anyway. As in branch_and_bound.c, removing it keeps
+    the closure and can only delay the rest, so such a state is never
+    longer than the one without it and is not labelled.
+
+  The witness of every state found is run through water_length, the
+  whole-board step every driver shares (core/water.h), so every answer is
+  checked against the real rules; --check also runs the full enumeration
+  for n <= 5 and compares.
+
+  Limits: the profile count still grows with the label range, and most
+  of it is in the middle rows, where no bound applies yet. On one core,
+  n = 5 takes about a second and n = 6 about 150 s with at most 79
+  million profiles (about 3 GB); simple --gray needs 15 minutes for
+  n = 6, multithreaded about 2 on one core. The peak grows about a
+  hundredfold per n (8 thousand, 1 million, 79 million for n = 4, 5, 6),
+  so n = 7 fits the key but not the memory of a workstation.
+
+  Usage: transfer_matrix [--lower-bound L] [--check]
+  With --lower-bound L only states longer than L are looked for, as in
+  branch_and_bound; a good L (from branch_and_bound or local_search)
+  saves the early rounds.
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "../core/water.h"
+
+// ---------------------------------------------------------------------
+// Global variables
+// ---------------------------------------------------------------------
+#define MAX_N 7                   // 7 profile cells of 9 bits fit a uint64_t
+
+static int g_n = 0;               // Board size, read from user
+static int g_target = 0;          // K: the label the current round looks for
+static WaterContext g_ctx;        // whole-board step, for the checks
+
+static inline int cellIndex(int x, int y) {
+    return y * g_n + x;
+}
+
+// ---------------------------------------------------------------------
+// Profile cells: 6 bits of label, 3 bits of neighbour status
+// (status = 3*a + b with a <= 1 and b <= 2 - a; for an initial cell the
+// number of initial neighbours)
+// ---------------------------------------------------------------------
+#define TIME_BITS 6
+#define SLOT_BITS 9
+#define HIGH_TIME 63              // filled after g_target, or never
+#define SLOT_MASK ((1ULL << SLOT_BITS) - 1ULL)
+
+static inline int slotTime(uint64_t key, int i) {
+    return (int)(key >> (SLOT_BITS * i)) & HIGH_TIME;
+}
+
+static inline int slotStatus(uint64_t key, int i) {
+    return (int)(key >> (SLOT_BITS * i + TIME_BITS)) & 7;
+}
+
+static inline uint64_t setSlot(uint64_t key, int i, uint64_t slot) {
+    return (key & ~(SLOT_MASK << (SLOT_BITS * i))) | (slot << (SLOT_BITS * i));
+}
+
+// Status of a cell labelled 'time' after learning a neighbour labelled v;
+// -1 if the cell can no longer be consistent
+static inline int addNeighbour(int time, int status, int v) {
+    if (time == 0) {
+        if (v != 0)
+            return status;
+        return status ? -1 : 1;            // see "Initial cells" above
+    }
+    if (time == HIGH_TIME) {
+        if (v >= g_target)
+            return status;
+        return status ? -1 : 3;            // a second one fills it by K
+    }
+    int a = status / 3, b = status % 3;
+    if (v < time - 1) {
+        if (a)
+            return -1;
+        a = 1;
+        if (b > 1)
+            b = 1;
+    } else if (v == time - 1) {
+        b = (b + 1 < 2 - a) ? b + 1 : 2 - a;
+    }
+    return 3 * a + b;
+}
+
+// Can the cell still be consistent with 'remaining' unknown neighbours?
+static inline int completable(int time, int status, int remaining) {
+    if (time == 0 || time == HIGH_TIME)
+        return 1;
+    return status / 3 + status % 3 + remaining >= 2;
+}
+
+// The slot stored for a cell with 'remaining' unknown neighbours, which
+// are the only cells still to read it (see "Unreadable labels" above)
+static inline uint64_t packSlot(int time, int status, int remaining) {
+    if (remaining == 0)
+        return 0ULL;
+    if (remaining == 1 && time == g_target && status == 2 && time > 0) {
+        time = HIGH_TIME;
+        status = 0;
+    }
+    return (uint64_t)time | ((uint64_t)status << TIME_BITS);
+}
+
+// Labels a profile cell accepts from its next neighbour, as bit t of a
+// mask (bit g_target + 1 stands for HIGH), by slot and by the number of
+// unknown neighbours it has left after that one. Filled in per round.
+static uint64_t g_accepts[2][1 << SLOT_BITS];
+
+static void fillAccepts(void) {
+    for (int remaining = 0; remaining < 2; remaining++) {
+        for (int slot = 0; slot < (1 << SLOT_BITS); slot++) {
+            int time = slot & HIGH_TIME;
+            int status = slot >> TIME_BITS;
+            uint64_t mask = 0ULL;
+            for (int t = 0; t <= g_target + 1; t++) {
+                int s = addNeighbour(time, status, (t > g_target) ? HIGH_TIME : t);
+                if (s >= 0 && completable(time, s, remaining))
+                    mask |= 1ULL << t;
+            }
+            g_accepts[remaining][slot] = mask;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------
+// Profile table: open addressing on the key, merging equal profiles
+// ---------------------------------------------------------------------
+#define EMPTY_KEY (~0ULL)             // keys use at most 63 bits
+
+// The value packs the largest finite label so far (bits 56-61) with a
+// witness: the initial cells of a labelling reaching it (n*n <= 49 bits).
+// A larger value is a larger label or, on ties, a larger witness, which
+// keeps the output reproducible.
+#define VALUE_BEST_SHIFT 56
+#define VALUE_WITNESS_MASK ((1ULL << VALUE_BEST_SHIFT) - 1ULL)
+
+typedef struct {
+    uint64_t key;
+    uint64_t value;
+} Entry;
+
+static inline int entryBest(uint64_t value) {
+    return (int)(value >> VALUE_BEST_SHIFT);
+}
+
+static inline uint64_t entryWitness(uint64_t value) {
+    return value & VALUE_WITNESS_MASK;
+}
+
+typedef struct {
+    Entry* slots;
+    size_t mask;
+    size_t count;
+} ProfileMap;
+
+static void mapInit(ProfileMap* map, size_t capacity) {
+    map->slots = (Entry*)malloc(sizeof(Entry) * capacity);
+    if (!map->slots) {
+        printf("Out of memory for %zu profiles\n", capacity);
+        exit(1);
+    }
+    for (size_t i = 0; i < capacity; i++)
+        map->slots[i].key = EMPTY_KEY;
+    map->mask = capacity - 1;
+    map->count = 0;
+}
+
+// Empty the map, sized for about 'expected' profiles: a table left large
+// by an earlier cell would otherwise be kept for the rest of the run
+static void mapReset(ProfileMap* map, size_t expected) {
+    size_t capacity = 1024;
+    while (capacity < expected * 2)
+        capacity *= 2;
+    if (map->mask + 1 > capacity * 2) {
+        free(map->slots);
+        mapInit(map, capacity);
+        return;
+    }
+    for (size_t i = 0; i <= map->mask; i++)
+        map->slots[i].key = EMPTY_KEY;
+    map->count = 0;
+}
+
+static inline size_t hashKey(uint64_t key) {
+    key ^= key >> 31;
+    key *= 0x9E3779B97F4A7C15ULL;
+    return (size_t)(key ^ (key >> 29));
+}
+
+static void mapInsert(ProfileMap* map, uint64_t key, uint64_t value);
+
+static void mapGrow(ProfileMap* map) {
+    Entry* old = map->slots;
+    size_t oldCapacity = map->mask + 1;
+    mapInit(map, oldCapacity * 2);
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (old[i].key != EMPTY_KEY)
+            mapInsert(map, old[i].key, old[i].value);
+    }
+    free(old);
+}
+
+static void mapInsert(ProfileMap* map, uint64_t key, uint64_t value) {
+    size_t i = hashKey(key) & map->mask;
+    while (map->slots[i].key != EMPTY_KEY) {
+        Entry* e = &map->slots[i];
+        if (e->key == key) {
+            if (value > e->value)
+                e->value = value;
+            return;
+        }
+        i = (i + 1) & map->mask;
+    }
+    map->slots[i].key = key;
+    map->slots[i].value = value;
+    if (++map->count * 4 > (map->mask + 1) * 3)
+        mapGrow(map);
+}
+
+// ---------------------------------------------------------------------
+// Inserts wait in a short queue: the table slot of each new key is
+// prefetched when it is queued and written when it leaves, so the cache
+// misses of several inserts overlap (about 1.7x faster at n = 6).
+// ---------------------------------------------------------------------
+#define INSERT_QUEUE 32
+
+typedef struct {
+    Entry items[INSERT_QUEUE];
+    int head;
+    int count;
+} InsertQueue;
+
+static inline void queueInsert(ProfileMap* map, InsertQueue* queue, uint64_t key, uint64_t value) {
+    if (queue->count == INSERT_QUEUE) {
+        const Entry* e = &queue->items[queue->head];
+        mapInsert(map, e->key, e->value);
+        queue->head = (queue->head + 1) % INSERT_QUEUE;
+        queue->count--;
+    }
+    __builtin_prefetch(&map->slots[hashKey(key) & map->mask], 1);
+    Entry* e = &queue->items[(queue->head + queue->count) % INSERT_QUEUE];
+    e->key = key;
+    e->value = value;
+    queue->count++;
+}
+
+static void queueFlush(ProfileMap* map, InsertQueue* queue) {
+    while (queue->count > 0) {
+        const Entry* e = &queue->items[queue->head];
+        mapInsert(map, e->key, e->value);
+        queue->head = (queue->head + 1) % INSERT_QUEUE;
+        queue->count--;
+    }
+}
+
+// ---------------------------------------------------------------------
+// After a full row the profile is that row, and the board above it is
+// finished. A profile and its mirror image (with the mirrored witness)
+// lead to mirrored completions, so the last cell of a row only stores
+// the smaller key.
+// ---------------------------------------------------------------------
+static uint64_t mirrorKey(uint64_t key) {
+    uint64_t out = 0ULL;
+    for (int i = 0; i < g_n; i++)
+        out |= ((key >> (SLOT_BITS * i)) & SLOT_MASK) << (SLOT_BITS * (g_n - 1 - i));
+    return out;
+}
+
+static uint64_t mirrorRows(uint64_t state, int rows) {
+    uint64_t out = 0ULL;
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < g_n; x++) {
+            if (water_isFilled(state, cellIndex(x, y)))
+                out |= 1ULL << cellIndex(g_n - 1 - x, y);
+        }
+    }
+    return out;
+}
+
+// The last cell of the top triangle y <= min(x, n-1-x), where some
+// symmetric image of every state has a cell filled at time K
+static int lastTriangleCell(void) {
+    int m = (g_n - 1) / 2;
+    return cellIndex(g_n - 1 - m, m);
+}
+
+// ---------------------------------------------------------------------
+// The transfer step: label cell (x, y) in every profile of 'from'
+// ---------------------------------------------------------------------
+static void labelCell(const ProfileMap* from, ProfileMap* to, int x, int y) {
+    const int n = g_n;
+    const int cell = cellIndex(x, y);
+    const int unlabelled = n * n - 1 - cell;
+    // past the triangle the label K must be there already
+    const int pastTriangle = cell >= lastTriangleCell();
+    // unknown neighbours left once (x, y) is labelled
+    const int leftRemaining = (y + 1 < n) ? 1 : 0;
+    const int newRemaining  = (x + 1 < n) + (y + 1 < n);
+
+    const uint64_t allLabels = (2ULL << (g_target + 1)) - 1ULL;   // 0..K and HIGH
+
+    InsertQueue queue = { .head = 0, .count = 0 };
+    for (size_t i = 0; i <= from->mask; i++) {
+        const Entry* e = &from->slots[i];
+        if (e->key == EMPTY_KEY)
+            continue;
+        int upTime = (y > 0) ? slotTime(e->key, x) : HIGH_TIME;
+        int leftTime = (x > 0) ? slotTime(e->key, x - 1) : HIGH_TIME;
+        int leftStatus = (x > 0) ? slotStatus(e->key, x - 1) : 0;
+        int best = entryBest(e->value);
+
+        // labels the two known neighbours accept, and the incumbent
+        uint64_t labels = allLabels;
+        if (y > 0)
+            labels &= g_accepts[0][(e->key >> (SLOT_BITS * x)) & SLOT_MASK];
+        if (x > 0)
+            labels &= g_accepts[leftRemaining][(e->key >> (SLOT_BITS * (x - 1))) & SLOT_MASK];
+        int reach = pastTriangle ? best : best + unlabelled;
+        if (reach < g_target)
+            labels &= allLabels & ~(1ULL << (g_target + 1)) & ~((1ULL << (g_target - reach + best)) - 1ULL);
+
+        for (; labels; labels &= labels - 1) {
+            int t = __builtin_ctzll(labels);
+            int time = (t > g_target) ? HIGH_TIME : t;
+            int newBest = (time != HIGH_TIME && time > best) ? time : best;
+
+            int status = 0;
+            if (x > 0)
+                status = addNeighbour(time, status, leftTime);
+            if (status >= 0 && y > 0)
+                status = addNeighbour(time, status, upTime);
+            if (status < 0 || !completable(time, status, newRemaining))
+                continue;
+
+            uint64_t key = e->key;
+            if (x > 0) {
+                int s = addNeighbour(leftTime, leftStatus, time);
+                key = setSlot(key, x - 1, packSlot(leftTime, s, leftRemaining));
+            }
+            key = setSlot(key, x, packSlot(time, status, newRemaining));
+
+            uint64_t value = e->value | ((time == 0) ? (1ULL << cell) : 0ULL);
+            if (newBest > best)
+                value = ((uint64_t)newBest << VALUE_BEST_SHIFT) | entryWitness(value);
+            if (x == n - 1) {
+                uint64_t mirrored = mirrorKey(key);
+                if (mirrored < key) {
+                    key = mirrored;
+                    value = (value & ~VALUE_WITNESS_MASK)
+                          | mirrorRows(entryWitness(value), y + 1);
+                }
+            }
+            queueInsert(to, &queue, key, value);
+        }
+    }
+    queueFlush(to, &queue);
+}
+
+// ---------------------------------------------------------------------
+// Full enumeration, for --check
+// ---------------------------------------------------------------------
+static int bruteForceMax(void) {
+    uint64_t total = 1ULL << (g_n * g_n);
+    int best = 0;
+    for (uint64_t s = 0; s < total; s++) {
+        int length = water_length(&g_ctx, s);
+        if (length > best)
+            best = length;
+    }
+    return best;
+}
+
+static double secondsSince(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + 1e-9 * (double)(now.tv_nsec - start->tv_nsec);
+}
+
+// ---------------------------------------------------------------------
+// The incumbent: a short hill climb from random sparse states, flipping
+// one or two cells at a time. It only decides where the rounds start.
+// ---------------------------------------------------------------------
+#define CLIMB_EVALUATIONS (1 << 18)
+#define CLIMB_RESTART 2048            // evaluations per random start
+
+static uint64_t g_rngState = 0x9E3779B97F4A7C15ULL;  // fixed seed
+
+static uint64_t nextRandom(void) {
+    // xorshift64
+    g_rngState ^= g_rngState << 13;
+    g_rngState ^= g_rngState >> 7;
+    g_rngState ^= g_rngState << 17;
+    return g_rngState;
+}
+
+static int climbIncumbent(uint64_t* bestState) {
+    const int cells = g_n * g_n;
+    uint64_t state = 0ULL;
+    int length = 0, best = 0;
+    for (int e = 0; e < CLIMB_EVALUATIONS; e++) {
+        uint64_t candidate = state;
+        if (e % CLIMB_RESTART == 0) {
+            candidate = 0ULL;
+            for (int c = 0; c < cells; c++) {
+                if (nextRandom() % 5 == 0)
+                    candidate |= 1ULL << c;
+            }
+        } else {
+            candidate ^= 1ULL << (nextRandom() % cells);
+            if (nextRandom() & 1)
+                candidate ^= 1ULL << (nextRandom() % cells);
+        }
+        int candidateLength = water_length(&g_ctx, candidate);
+        if (e % CLIMB_RESTART == 0 || candidateLength >= length) {
+            state = candidate;
+            length = candidateLength;
+        }
+        if (length > best) {
+            best = length;
+            *bestState = state;
+        }
+    }
+    return best;
+}
+
+// ---------------------------------------------------------------------
+// One round: label the whole board with labels up to g_target. Every
+// final profile is a consistent labelling that uses g_target; returns
+// how many there are, with the longest of their witnesses.
+// ---------------------------------------------------------------------
+static size_t runRound(ProfileMap maps[2], const struct timespec* start,
+                       size_t* peak, uint64_t* bestState, int* bestLength) {
+    int cur = 0;
+    fillAccepts();
+    mapReset(&maps[0], 1);
+    mapInsert(&maps[0], 0ULL, 0ULL);
+
+    for (int y = 0; y < g_n; y++) {
+        for (int x = 0; x < g_n; x++) {
+            mapReset(&maps[cur ^ 1], maps[cur].count);
+            labelCell(&maps[cur], &maps[cur ^ 1], x, y);
+            cur ^= 1;
+            if (maps[cur].count > *peak)
+                *peak = maps[cur].count;
+        }
+        printf("Row %d: %zu profiles (%.1f s)\n", y, maps[cur].count, secondsSince(start));
+        fflush(stdout);
+    }
+
+    *bestLength = 0;
+    for (size_t i = 0; i <= maps[cur].mask; i++) {
+        const Entry* e = &maps[cur].slots[i];
+        if (e->key == EMPTY_KEY)
+            continue;
+        uint64_t witness = entryWitness(e->value);
+        int length = water_length(&g_ctx, witness);
+        if (length > *bestLength || (length == *bestLength && witness > *bestState)) {
+            *bestLength = length;
+            *bestState = witness;
+        }
+    }
+    return maps[cur].count;
+}
+
+// ---------------------------------------------------------------------
+// main()
+// ---------------------------------------------------------------------
+int main(int argc, char **argv) {
+    int check = 0;
+    int lowerBound = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--check") == 0) {
+            check = 1;
+        } else if (strcmp(argv[a], "--lower-bound") == 0 && a + 1 < argc) {
+            lowerBound = atoi(argv[++a]);
+        } else {
+            printf("Usage: %s [--lower-bound L] [--check]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("Enter grid size (1 to %d): ", MAX_N);
+    if (scanf("%d", &g_n) != 1 || g_n < 1 || g_n > MAX_N) {
+        printf("Invalid input. Please run again with n between 1 and %d.\n", MAX_N);
+        return 1;
+    }
+    if (lowerBound < 0 || lowerBound >= g_n * g_n) {
+        printf("The lower bound must be between 0 and %d.\n", g_n * g_n - 1);
+        return 1;
+    }
+    water_init(&g_ctx, g_n, 0);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    ProfileMap maps[2];
+    mapInit(&maps[0], 1024);
+    mapInit(&maps[1], 1024);
+
+    uint64_t bestState = 0ULL;
+    int maxLength = climbIncumbent(&bestState);
+    printf("Hill climb: length %d\n", maxLength);
+
+    int status = 0;
+    size_t peak = 1;
+    g_target = (lowerBound > maxLength) ? lowerBound : maxLength;
+    while (g_target < g_n * g_n) {
+        printf("Looking for a state longer than %d\n", g_target);
+        int length = 0;
+        uint64_t state = 0ULL;
+        if (runRound(maps, &start, &peak, &state, &length) == 0)
+            break;
+        printf("Found a state of length %d\n", length);
+        if (length <= g_target) {
+            printf("Cross-check FAILED: the witness has length %d under water_length\n",
+                   length);
+            status = 1;
+            break;
+        }
+        maxLength = length;
+        bestState = state;
+        g_target = length;
+    }
+
+    printf("Profiles at most %zu, %.1f s\n", peak, secondsSince(&start));
+    if (g_target > maxLength) {
+        printf("No state is longer than %d, so f(%d) <= %d\n", g_target, g_n, g_target);
+    } else {
+        printf("Max length = %d\n", maxLength);
+        printf("Best state = %" PRIu64 "\n", bestState);
+        water_print(&g_ctx, bestState);
+    }
+
+    if (check) {
+        if (g_n > 5) {
+            printf("--check enumerates 2^(n*n) states and is only run for n <= 5\n");
+        } else {
+            int expected = bruteForceMax();
+            int agrees = (g_target > maxLength) ? expected <= g_target : expected == maxLength;
+            printf("Full enumeration: max length = %d (%s)\n", expected,
+                   agrees ? "agrees" : "DISAGREES");
+            if (!agrees)
+                status = 1;
+        }
+    }
+
+    free(maps[0].slots);
+    free(maps[1].slots);
+    return status;
+}